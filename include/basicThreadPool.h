@@ -0,0 +1,412 @@
+/**
+ * @file basicThreadPool.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 基于策略的线程池模板,任务队列、任务类型、空闲等待方式与统计信息在编译期选择,未使用的功能不产生任何开销
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BASICTHREADPOOL_H
+#define BASICTHREADPOOL_H
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <limits>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <shared_mutex>
+#include <type_traits>
+#include <condition_variable>
+#include "pooledTask.h"
+
+namespace my_thread_poll
+{
+    /*
+    队列策略:通过queue_type<Task>提供任务队列,需要实现
+    bool push(Task &&task)  加入任务,队列已满时返回false
+    bool pop(Task &task)    取出任务,队列为空时返回false
+    std::size_t size()      当前任务数量,使用顺序一致的原子变量维护,供空闲策略判断是否需要等待
+    */
+    struct unbounded_queue_policy // 无上限的互斥锁队列
+    {
+        template <typename Task>
+        class queue_type
+        {
+        private:
+            std::mutex mutex;
+            std::deque<Task, slab_allocator<Task>> tasks;
+            std::atomic<std::size_t> count{0};
+
+        protected:
+            bool push_below(Task &&task, std::size_t capacity) // 在同一把锁内检查数量并加入任务,队列中已有capacity个任务时返回false
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (tasks.size() >= capacity)
+                    return false;
+                tasks.push_back(std::move(task));
+                count.fetch_add(1);
+                return true;
+            }
+
+        public:
+            bool push(Task &&task) { return push_below(std::move(task), std::numeric_limits<std::size_t>::max()); }
+            bool pop(Task &task)
+            {
+                if (count.load() == 0)
+                    return false;
+                std::lock_guard<std::mutex> lock(mutex);
+                if (tasks.empty())
+                    return false;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                count.fetch_sub(1);
+                return true;
+            }
+            std::size_t size() const { return count.load(); }
+        };
+    };
+
+    template <std::size_t Capacity>
+    struct bounded_queue_policy // 有上限的互斥锁队列,队列已满时拒绝新任务
+    {
+        static_assert(Capacity > 0, "bounded queue capacity must be positive");
+        template <typename Task>
+        class queue_type : public unbounded_queue_policy::queue_type<Task>
+        {
+        public:
+            bool push(Task &&task) { return this->push_below(std::move(task), Capacity); }
+        };
+    };
+
+    /*
+    任务策略:task_type为队列中存放的任务类型,make将任意可调用对象转换为task_type
+    */
+    struct pooled_task_policy // 只可移动的pooled_task,控制块来自slab_allocator
+    {
+        using task_type = pooled_task;
+        template <typename Func>
+        static task_type make(Func &&func) { return task_type(std::forward<Func>(func)); }
+    };
+
+    struct function_task_policy // std::function<void()>,只可移动的可调用对象通过shared_ptr包装
+    {
+        using task_type = std::function<void()>;
+        template <typename Func>
+        static task_type make(Func &&func)
+        {
+            using func_t = std::decay_t<Func>;
+            if constexpr (std::is_copy_constructible_v<func_t>)
+                return task_type(std::forward<Func>(func));
+            else
+                return [holder = std::make_shared<func_t>(std::forward<Func>(func))]() { (*holder)(); };
+        }
+    };
+
+    /*
+    空闲策略:决定没有任务时工作线程如何等待,需要实现
+    template <typename Pred> void wait(Pred ready)  等待到ready()为true
+    void notify_one() / void notify_all()           生产者加入任务或线程池停止时调用
+    bool runnable() const                           当前是否允许执行任务,pausable时暂停期间返回false
+    static constexpr bool pausable                  是否支持pause/resume
+    */
+    class condvar_idle_policy // 条件变量等待,生产者只在有线程等待时才加锁通知
+    {
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<std::size_t> waiters{0};
+
+    public:
+        static constexpr bool pausable = false;
+        constexpr bool runnable() const noexcept { return true; }
+
+        template <typename Pred>
+        void wait(Pred ready)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            waiters.fetch_add(1); // 先登记再检查条件,与生产者先修改队列再检查等待数量相对应,避免错过唤醒
+            while (!ready())
+            {
+                cv.wait(lock);
+            }
+            waiters.fetch_sub(1);
+        }
+        void notify_one()
+        {
+            if (waiters.load() == 0)
+                return;
+            { std::lock_guard<std::mutex> lock(mutex); }
+            cv.notify_one();
+        }
+        void notify_all()
+        {
+            { std::lock_guard<std::mutex> lock(mutex); }
+            cv.notify_all();
+        }
+    };
+
+    class spin_idle_policy // 自旋并让出时间片,不阻塞,唤醒延迟最低但空闲时占用CPU
+    {
+    public:
+        static constexpr bool pausable = false;
+        constexpr bool runnable() const noexcept { return true; }
+
+        template <typename Pred>
+        void wait(Pred ready)
+        {
+            while (!ready())
+            {
+                std::this_thread::yield();
+            }
+        }
+        void notify_one() noexcept {}
+        void notify_all() noexcept {}
+    };
+
+    template <typename IdlePolicy>
+    class pausable_idle_policy : public IdlePolicy // 为空闲策略增加暂停支持,暂停期间工作线程不取任务
+    {
+    private:
+        std::atomic<bool> paused{false};
+
+    public:
+        static constexpr bool pausable = true;
+        bool runnable() const noexcept { return !paused.load(); }
+        void pause() { paused.store(true); }
+        void resume()
+        {
+            paused.store(false);
+            this->notify_all();
+        }
+    };
+
+    /*
+    统计策略:on_submit/on_reject/on_execute分别在任务加入队列、被拒绝、执行完毕时调用
+    */
+    struct no_stats_policy // 不统计,所有调用在内联后消失
+    {
+        void on_submit() noexcept {}
+        void on_reject() noexcept {}
+        void on_execute() noexcept {}
+    };
+
+    struct atomic_stats_policy // 使用原子计数统计任务数量
+    {
+        std::atomic<std::size_t> submitted{0};
+        std::atomic<std::size_t> rejected{0};
+        std::atomic<std::size_t> executed{0};
+        void on_submit() noexcept { submitted.fetch_add(1, std::memory_order_relaxed); }
+        void on_reject() noexcept { rejected.fetch_add(1, std::memory_order_relaxed); }
+        void on_execute() noexcept { executed.fetch_add(1, std::memory_order_relaxed); }
+    };
+
+    /*
+    异常策略:工作线程捕获任务抛出的异常后调用handle(std::exception_ptr),
+    static constexpr bool settable表示是否支持在运行时通过set_exception_handler设置处理函数
+    */
+    struct stderr_exception_policy // 输出到标准错误
+    {
+        static constexpr bool settable = false;
+        void handle(std::exception_ptr e) noexcept
+        {
+            try
+            {
+                std::rethrow_exception(e);
+            }
+            catch (const std::exception &ex)
+            {
+                std::cerr << "[basic_thread_pool][error]: " << ex.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << "[basic_thread_pool][error]: unknown exception" << std::endl;
+            }
+        }
+    };
+
+    class handler_exception_policy : private stderr_exception_policy // 交给运行时设置的处理函数,与ThreadPool::set_exception_handler相同,未设置时输出到标准错误
+    {
+    private:
+        std::shared_mutex mutex;
+        std::function<void(std::exception_ptr)> handler;
+
+    public:
+        static constexpr bool settable = true;
+        void set_handler(std::function<void(std::exception_ptr)> h)
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            handler = std::move(h);
+        }
+        void handle(std::exception_ptr e)
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if (handler)
+            {
+                handler(e);
+                return;
+            }
+            lock.unlock();
+            stderr_exception_policy::handle(e);
+        }
+    };
+
+    /*
+    basic_thread_pool是只保留核心路径的线程池模板:固定数量的工作线程从单个队列中取任务执行,
+    五个策略在编译期组合,提交与取任务的路径可以完全内联;析构时等待队列中的任务执行完毕
+    提交时先登记为正在提交再检查stopping,工作线程在没有正在进行的提交后才退出,
+    因此通过检查的提交不会在shutdown之后把任务留在无人执行的队列中
+    它不包含ThreadPool的分片、本地队列、任务类别、截止时间、补偿线程等运行时功能,
+    需要这些功能时仍然使用ThreadPool
+    */
+    template <typename QueuePolicy = unbounded_queue_policy,
+              typename TaskPolicy = pooled_task_policy,
+              typename IdlePolicy = condvar_idle_policy,
+              typename StatsPolicy = no_stats_policy,
+              typename ExceptionPolicy = stderr_exception_policy>
+    class basic_thread_pool
+    {
+    public:
+        using task_type = typename TaskPolicy::task_type;
+
+    private:
+        typename QueuePolicy::template queue_type<task_type> queue; // 任务队列
+        IdlePolicy idle;                                            // 空闲等待方式
+        [[no_unique_address]] StatsPolicy statistics;               // 统计信息
+        [[no_unique_address]] ExceptionPolicy exceptions;           // 任务异常的处理方式
+        std::atomic<bool> stopping{false};                          // 是否正在停止
+        std::atomic<std::size_t> pushing{0};                        // 已通过stopping检查、尚未加入队列的提交数量
+        std::vector<std::thread> workers;                           // 工作线程
+
+        bool ready() { return (idle.runnable() && queue.size() > 0) || stopping.load(); }
+
+        void worker_loop()
+        {
+            while (true)
+            {
+                task_type task;
+                if (idle.runnable() && queue.pop(task))
+                {
+                    try
+                    {
+                        task();
+                    }
+                    catch (...)
+                    {
+                        exceptions.handle(std::current_exception());
+                    }
+                    statistics.on_execute();
+                    continue;
+                }
+                if (stopping.load() && pushing.load() == 0 && queue.size() == 0) // 仍有提交在进行时,ready()因stopping为true而立即返回,短暂自旋等待其结束
+                {
+                    return;
+                }
+                idle.wait([this]() { return ready(); });
+            }
+        }
+
+        void push(task_type &&task)
+        {
+            struct pushing_guard // 与shutdown的stopping.store配对:先登记再检查,工作线程看到pushing为0时不会再有任务加入
+            {
+                std::atomic<std::size_t> &pushing;
+                explicit pushing_guard(std::atomic<std::size_t> &p) : pushing(p) { pushing.fetch_add(1); }
+                ~pushing_guard() { pushing.fetch_sub(1); }
+            };
+            {
+                pushing_guard guard(pushing);
+                if (stopping.load())
+                {
+                    throw std::runtime_error("ThreadPool is terminating");
+                }
+                if (!queue.push(std::move(task)))
+                {
+                    statistics.on_reject();
+                    throw std::runtime_error("ThreadPool is full");
+                }
+                statistics.on_submit();
+            }
+            idle.notify_one();
+        }
+
+    public:
+        explicit basic_thread_pool(std::size_t thread_count)
+        {
+            workers.reserve(thread_count);
+            for (std::size_t i = 0; i < thread_count; ++i)
+            {
+                workers.emplace_back([this]() { worker_loop(); });
+            }
+        }
+
+        ~basic_thread_pool() { shutdown(); }
+        basic_thread_pool(const basic_thread_pool &) = delete;
+        basic_thread_pool &operator=(const basic_thread_pool &) = delete;
+
+        template <typename Func, typename... Args>
+        auto submit(Func &&f, Args &&...args) -> std::future<decltype(f(args...))> // 提交任务并返回future
+        {
+            auto [task, res] = package_task(std::forward<Func>(f), std::forward<Args>(args)...);
+            push(TaskPolicy::make(std::move(task)));
+            return std::move(res);
+        }
+
+        template <typename Func, typename... Args>
+        void post(Func &&f, Args &&...args) // 提交任务,不创建future,任务的异常交给异常策略
+        {
+            if constexpr (sizeof...(Args) == 0)
+            {
+                push(TaskPolicy::make(std::forward<Func>(f)));
+            }
+            else
+            {
+                push(TaskPolicy::make([func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable
+                {
+                    func(bound_args...);
+                }));
+            }
+        }
+
+        void pause() requires IdlePolicy::pausable { idle.pause(); }   // 暂停取任务,正在执行的任务不受影响
+        void resume() requires IdlePolicy::pausable { idle.resume(); } // 恢复取任务
+        void set_exception_handler(std::function<void(std::exception_ptr)> handler) requires ExceptionPolicy::settable // 设置异常处理函数
+        {
+            exceptions.set_handler(std::move(handler));
+        }
+
+        void shutdown() // 不再接收新任务,等待队列中的任务执行完毕后结束工作线程
+        {
+            if constexpr (IdlePolicy::pausable)
+            {
+                idle.resume();
+            }
+            stopping.store(true);
+            idle.notify_all();
+            for (auto &worker : workers)
+            {
+                if (worker.joinable())
+                    worker.join();
+            }
+        }
+
+        std::size_t get_task_count() const { return queue.size(); }
+        std::size_t get_thread_count() const { return workers.size(); }
+        const StatsPolicy &stats() const noexcept { return statistics; }
+    };
+
+    using default_thread_pool = basic_thread_pool<>; // 最常用的策略组合:无上限的单队列、pooled_task、条件变量等待、不统计;它不是ThreadPool,没有分片与本地队列等功能
+};
+
+#endif // BASICTHREADPOOL_H
@@ -0,0 +1,69 @@
+/**
+ * @file configWatcher.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 基于inotify监听配置文件,文件修改后重新加载并将[thread_pool]分区的设置应用到正在运行的线程池
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cstddef>
+#include "threadPool.h"
+
+namespace my_thread_poll
+{
+    /*
+    ConfigWatcher的工作方式如下:
+    1.监听线程通过inotify监听配置文件所在的目录,文件被写入并关闭(IN_CLOSE_WRITE)或被重命名覆盖(IN_MOVED_TO)时开始计时
+    2.去抖动:最后一次修改之后debounce时间内没有新的修改才重新加载,编辑器多次写入只触发一次重新加载
+    3.重新加载时先完整校验[thread_pool]分区:inital_thread_count必须是1到max_thread_count之间的整数,
+    max_task_count必须是非负整数(0表示不限制),缺少的键保持原设置;任一项无效时不做任何修改
+    4.校验通过后通过set_max_task_count、add_thread、remove_thread调整线程池,正在执行与排队中的任务不受影响
+    监听线程不是线程池的工作线程,remove_thread等待被移除的线程执行完当前任务时不会阻塞工作线程
+    ConfigWatcher需要在线程池之前析构
+    */
+    class ConfigWatcher
+    {
+    public:
+        ConfigWatcher(ThreadPool &pool, const std::string &filename,
+                      std::chrono::milliseconds debounce = std::chrono::milliseconds(200),
+                      std::size_t max_thread_count = 1024);
+        ~ConfigWatcher();
+        ConfigWatcher(const ConfigWatcher &) = delete;
+        ConfigWatcher &operator=(const ConfigWatcher &) = delete;
+
+        bool reload();                   // 立即重新加载并应用配置,配置无效或应用失败时返回false
+        void stop();                     // 停止监听线程
+        std::size_t get_reload_count();  // 获取成功应用配置的次数
+        std::size_t get_error_count();   // 获取加载、校验或应用失败的次数
+
+    private:
+        ThreadPool &pool;
+        const std::string filename;                 // 配置文件路径
+        std::string watched_name;                   // 配置文件在目录中的文件名,用于过滤inotify事件
+        const std::chrono::milliseconds debounce;   // 去抖动时间
+        const std::size_t max_thread_count;         // 允许设置的最大线程数量
+        int inotify_fd = -1;
+        int event_fd = -1;                          // 停止时唤醒监听线程
+        std::mutex reload_mutex;                    // 串行化监听线程与手动调用的reload
+        std::atomic<std::size_t> reload_count{0};
+        std::atomic<std::size_t> error_count{0};
+        std::atomic<bool> stopping{false};
+        std::thread thread;                         // 监听线程
+
+        void run();                                 // 监听线程的循环
+        bool fail(const std::string &message);      // 记录失败并输出到标准错误,返回false
+    };
+};
+
+#endif // CONFIGWATCHER_H
@@ -1,13 +1,32 @@
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
 
 namespace utils
 {
 
     class Value  // 封装一个Value对象，支持string、int、double、bool类型，可以实现多个类型转换为Value对象，并且可以转换为多个类型
     {
+    public:
+        enum class Type : unsigned char // 最近一次赋值的类型
+        {
+            STRING,
+            INT,
+            DOUBLE,
+            BOOL
+        };
     private:
-        std::string m_value; 
+        std::string m_value; //文本形式,保存与显示时使用
+        int m_int = 0;       //按atoi规则解析的整数
+        double m_double = 0; //按atof规则解析的浮点数
+        bool m_bool = false; //文本是否为"true"
+        Type m_type = Type::STRING;
+        void parse(); //文本修改后重新解析缓存的数值,使用std::from_chars,不依赖区域设置也不分配内存
     public:
         //支持各个类型的构造函数
         Value();
@@ -26,42 +45,174 @@ namespace utils
         Value& operator=(const char* value);
 
         //对于值的判断
-        bool operator==(const Value& other);
-        bool operator!=(const Value& other);
-
-        //这里实现可以将Value对象转换为任意类型
-        operator int();
-        operator double();
-        operator bool();
-        operator std::string();
+        bool operator==(const Value& other) const;
+        bool operator!=(const Value& other) const;
+
+        //这里实现可以将Value对象转换为任意类型,数值在赋值时已经解析,转换只是读取缓存
+        operator int() const { return m_int; }
+        operator double() const { return m_double; }
+        operator bool() const { return m_bool; }
+        operator std::string() const;
+        Type type() const { return m_type; } //获取最近一次赋值的类型
+    };
+
+    /*
+    FlatMap是按键排序的平坦数组,用来代替std::map存储分区与键值:
+    1.数组中只存放指向节点的指针,查找为连续内存上的二分查找,键可以直接使用std::string_view,命中时不分配内存
+    2.键值存放在独立分配的节点中,插入与删除其他键只移动指针,operator[]与get返回的引用与std::map一样保持有效,
+    直到对应的键被删除或整个FlatMap被清空、重新加载
+    3.遍历顺序与std::map相同(按键的字典序),str与save的输出保持不变
+    4.加载文件时先收集全部键值,再通过assign_unsorted一次排序,避免逐个插入的移动开销
+    */
+    template <typename T>
+    class FlatMap
+    {
+    public:
+        using value_type = std::pair<std::string, T>;
+
+    private:
+        using node_list = std::vector<std::unique_ptr<value_type>>;
+
+        template <typename Base, typename V>
+        class node_iterator //遍历节点指针数组,解引用得到键值
+        {
+        private:
+            Base m_it;
+
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = std::remove_const_t<V>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = V*;
+            using reference = V&;
+
+            node_iterator() = default;
+            explicit node_iterator(Base it): m_it(it) {}
+            template <typename OtherBase, typename OtherV, typename = std::enable_if_t<std::is_convertible_v<OtherBase, Base>>>
+            node_iterator(const node_iterator<OtherBase, OtherV>& other): m_it(other.base()) {}
+
+            reference operator*() const { return **m_it; }
+            pointer operator->() const { return m_it->get(); }
+            node_iterator& operator++() { ++m_it; return *this; }
+            node_iterator operator++(int) { node_iterator old=*this; ++m_it; return old; }
+            node_iterator& operator--() { --m_it; return *this; }
+            node_iterator operator--(int) { node_iterator old=*this; --m_it; return old; }
+            bool operator==(const node_iterator& other) const { return m_it==other.m_it; }
+            bool operator!=(const node_iterator& other) const { return m_it!=other.m_it; }
+            Base base() const { return m_it; }
+        };
+
+    public:
+        using iterator = node_iterator<typename node_list::iterator, value_type>;
+        using const_iterator = node_iterator<typename node_list::const_iterator, const value_type>;
+
+        FlatMap() = default;
+        FlatMap(const FlatMap& other) { *this=other; }
+        FlatMap(FlatMap&&) noexcept = default;
+        FlatMap& operator=(FlatMap&&) noexcept = default;
+        FlatMap& operator=(const FlatMap& other) //逐个复制节点
+        {
+            if(this!=&other)
+            {
+                node_list items;
+                items.reserve(other.m_items.size());
+                for(const auto& item: other.m_items)
+                    items.push_back(std::make_unique<value_type>(*item));
+                m_items=std::move(items);
+            }
+            return *this;
+        }
+
+        iterator begin() { return iterator(m_items.begin()); }
+        iterator end() { return iterator(m_items.end()); }
+        const_iterator begin() const { return const_iterator(m_items.begin()); }
+        const_iterator end() const { return const_iterator(m_items.end()); }
+        std::size_t size() const { return m_items.size(); }
+        bool empty() const { return m_items.empty(); }
+        void clear() { m_items.clear(); }
+
+        iterator find(std::string_view key) //查找键,不存在时返回end()
+        {
+            auto it=lower_bound(key);
+            return iterator(it!=m_items.end()&&(*it)->first==key?it:m_items.end());
+        }
+        const_iterator find(std::string_view key) const
+        {
+            auto it=std::lower_bound(m_items.begin(),m_items.end(),key,less());
+            return const_iterator(it!=m_items.end()&&(*it)->first==key?it:m_items.end());
+        }
+        std::size_t count(std::string_view key) const { return find(key)!=end()?1:0; }
+
+        T& operator[](std::string_view key) //键不存在时插入默认值
+        {
+            auto it=lower_bound(key);
+            if(it==m_items.end()||(*it)->first!=key)
+            {
+                it=m_items.insert(it,std::make_unique<value_type>(std::string(key),T()));
+            }
+            return (*it)->second;
+        }
+
+        std::size_t erase(std::string_view key)
+        {
+            iterator it=find(key);
+            if(it==end()) return 0;
+            m_items.erase(it.base());
+            return 1;
+        }
+
+        void assign_unsorted(std::vector<value_type>&& items) //用未排序的键值替换全部内容,键重复时保留最后一个
+        {
+            std::stable_sort(items.begin(),items.end(),[](const value_type& a,const value_type& b){ return a.first<b.first; });
+            node_list nodes;
+            nodes.reserve(items.size());
+            for(std::size_t i=0;i<items.size();++i)
+            {
+                if(i+1<items.size()&&items[i+1].first==items[i].first) continue;
+                nodes.push_back(std::make_unique<value_type>(std::move(items[i])));
+            }
+            m_items=std::move(nodes);
+        }
+
+    private:
+        node_list m_items;
+
+        struct less
+        {
+            bool operator()(const std::unique_ptr<value_type>& a,std::string_view key) const { return std::string_view(a->first)<key; }
+        };
+        typename node_list::iterator lower_bound(std::string_view key) { return std::lower_bound(m_items.begin(),m_items.end(),key,less()); }
     };
 
-    typedef std::map<std::string, Value> Section;
+    typedef FlatMap<Value> Section;
 
     class IniFile
     {
         private:
             std::string m_filename;
-            std::map<std::string, Section> m_sections;
-            std::string trim(std::string s);  //去除字符串两边的空格 
+            FlatMap<Section> m_sections;
+            static std::string_view trim_view(std::string_view s); //去除两边的空格,不复制字符串
+            bool parse(std::string_view data); //在内存中解析ini内容,只为分区名、键与值创建字符串
+            bool load_stream(const std::string& filename); //无法映射的文件(管道、特殊文件等)整体读入内存后解析
         public:
             IniFile();
             IniFile(const std::string& filename);
             ~IniFile();
 
-            bool load(const std::string& filename);  //加载ini文件
+            bool load(const std::string& filename);  //加载ini文件,配置文件大小的普通文件通过read读入后原地解析,大文件通过mmap映射后解析
             bool save(const std::string& filename);  //保存ini文件
             void show(); //显示ini文件内容
             void clear(); //清空ini文件内容
             
-            Value& get(const std::string& section,const std::string& key); //获取指定分区指定键的值
-            void set(const std::string& section,const std::string& key,const Value& value); //设置指定分区指定键的值
-            bool remove(const std::string& section,const std::string& key); //删除指定分区指定键的值
+            Value& get(std::string_view section,std::string_view key); //获取指定分区指定键的值,不存在时插入空值
+            const Value* find(std::string_view section,std::string_view key) const; //查找指定分区指定键的值,不存在时返回nullptr,不修改内容
+            void set(std::string_view section,std::string_view key,const Value& value); //设置指定分区指定键的值
+            bool remove(std::string_view section,std::string_view key); //删除指定分区指定键的值
             
-            bool has(const std::string& section,const std::string& key); //判断键值对是否存在
-            bool has(const std::string& section);// 判断分区是否存在
+            bool has(std::string_view section,std::string_view key) const; //判断键值对是否存在
+            bool has(std::string_view section) const;// 判断分区是否存在
             
-            Section& operator[](const std::string& section); // 重载[]操作符,用来访问分区中的键值
+            Section& operator[](std::string_view section); // 重载[]操作符,用来访问分区中的键值
             std::string str(); //将字符串转换为ini文件格式
     };
 };
\ No newline at end of file
@@ -0,0 +1,243 @@
+/**
+ * @file parallelAlgorithm.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 在线程池上执行的并行算法:parallel_sort、parallel_transform、parallel_inclusive_scan与parallel_count_if
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PARALLELALGORITHM_H
+#define PARALLELALGORITHM_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <numeric>
+#include <iterator>
+#include <exception>
+#include <algorithm>
+#include <functional>
+#include "threadPool.h"
+
+namespace my_thread_poll
+{
+    namespace parallel_detail
+    {
+        inline constexpr std::size_t cache_bytes = 256 * 1024; // 每个分块处理的数据量,约为一个核心的二级缓存大小
+
+        template <typename T>
+        std::size_t chunk_size(std::size_t n, std::size_t participants) // 分块大小:不超过缓存大小,且分块数量不少于参与线程数量
+        {
+            std::size_t by_cache = std::max<std::size_t>(cache_bytes / std::max<std::size_t>(sizeof(T), 1), 1);
+            std::size_t by_threads = (n + participants - 1) / participants;
+            return std::max<std::size_t>(std::min(by_cache, by_threads), 1);
+        }
+
+        inline std::size_t participants(ThreadPool &pool) // 参与计算的线程数量:工作线程 + 调用线程
+        {
+            return pool.get_thread_count() + 1;
+        }
+
+        /*
+        run_chunks将count个分块交给线程池与调用线程共同执行,工作方式如下:
+        1.向线程池提交最多participants-1个辅助任务,辅助任务与调用线程通过原子计数领取分块,直到分块领取完毕
+        2.调用线程领取完分块后,等待其他线程正在执行的分块结束
+        3.共享状态由shared_ptr管理,在所有分块结束之后才开始执行的辅助任务不会访问调用者的栈
+        线程池不接收新任务时,全部分块由调用线程执行;任意分块抛出异常后剩余分块不再执行,调用线程重新抛出第一个异常
+        */
+        template <typename Func>
+        void run_chunks(ThreadPool &pool, std::size_t count, Func &&func)
+        {
+            if (count == 0)
+                return;
+            if (count == 1)
+            {
+                func(std::size_t(0));
+                return;
+            }
+            struct state_t
+            {
+                std::atomic<std::size_t> next{0};     // 下一个待领取的分块
+                std::atomic<std::size_t> finished{0}; // 已经结束的分块数量
+                std::atomic<bool> failed{false};      // 是否有分块抛出异常
+                std::mutex error_mutex;
+                std::exception_ptr error;
+                std::size_t count;
+                std::remove_reference_t<Func> *func;
+            };
+            auto state = std::make_shared<state_t>();
+            state->count = count;
+            state->func = &func;
+            auto work = [](state_t &st)
+            {
+                std::size_t index;
+                while ((index = st.next.fetch_add(1, std::memory_order_relaxed)) < st.count)
+                {
+                    if (!st.failed.load(std::memory_order_relaxed))
+                    {
+                        try
+                        {
+                            (*st.func)(index);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(st.error_mutex);
+                            if (!st.error)
+                                st.error = std::current_exception();
+                            st.failed.store(true, std::memory_order_relaxed);
+                        }
+                    }
+                    if (st.finished.fetch_add(1, std::memory_order_acq_rel) + 1 == st.count)
+                    {
+                        st.finished.notify_all();
+                    }
+                }
+            };
+            std::size_t helpers = std::min(participants(pool) - 1, count - 1);
+            for (std::size_t i = 0; i < helpers; ++i)
+            {
+                try
+                {
+                    pool.post([state, work]() { work(*state); });
+                }
+                catch (...) // 线程池不接收新任务,剩余分块由调用线程执行
+                {
+                    break;
+                }
+            }
+            work(*state);
+            std::size_t done;
+            while ((done = state->finished.load(std::memory_order_acquire)) != count)
+            {
+                state->finished.wait(done, std::memory_order_acquire);
+            }
+            if (state->error)
+            {
+                std::rethrow_exception(state->error);
+            }
+        }
+    };
+
+    template <typename RandomIt, typename OutputIt, typename UnaryOp>
+    OutputIt parallel_transform(ThreadPool &pool, RandomIt first, RandomIt last, OutputIt d_first, UnaryOp op) // 对每个元素执行op并写入d_first开始的区间,两个区间均需支持随机访问
+    {
+        using value_t = typename std::iterator_traits<RandomIt>::value_type;
+        std::size_t n = static_cast<std::size_t>(last - first);
+        std::size_t chunk = parallel_detail::chunk_size<value_t>(n, parallel_detail::participants(pool));
+        std::size_t count = (n + chunk - 1) / chunk;
+        parallel_detail::run_chunks(pool, count, [&](std::size_t index)
+        {
+            std::size_t begin = index * chunk, end = std::min(n, begin + chunk);
+            std::transform(first + begin, first + end, d_first + begin, op);
+        });
+        return d_first + n;
+    }
+
+    template <typename RandomIt, typename UnaryPred>
+    typename std::iterator_traits<RandomIt>::difference_type parallel_count_if(ThreadPool &pool, RandomIt first, RandomIt last, UnaryPred pred) // 统计满足pred的元素数量
+    {
+        using value_t = typename std::iterator_traits<RandomIt>::value_type;
+        using diff_t = typename std::iterator_traits<RandomIt>::difference_type;
+        std::size_t n = static_cast<std::size_t>(last - first);
+        std::size_t chunk = parallel_detail::chunk_size<value_t>(n, parallel_detail::participants(pool));
+        std::size_t count = (n + chunk - 1) / chunk;
+        std::vector<diff_t> partial(count, 0);
+        parallel_detail::run_chunks(pool, count, [&](std::size_t index)
+        {
+            std::size_t begin = index * chunk, end = std::min(n, begin + chunk);
+            partial[index] = std::count_if(first + begin, first + end, pred);
+        });
+        diff_t total = 0;
+        for (diff_t c : partial)
+            total += c;
+        return total;
+    }
+
+    /*
+    parallel_inclusive_scan分为三个阶段:
+    1.各分块独立计算块内前缀和并写入输出,记录每个分块的总和
+    2.调用线程串行计算各分块之前所有元素的总和(分块数量很少)
+    3.除第一个分块外,各分块将之前所有元素的总和累加到输出中
+    op需要满足结合律,计算顺序与std::inclusive_scan一样不保证从左到右
+    */
+    template <typename RandomIt, typename OutputIt, typename BinaryOp = std::plus<>>
+    OutputIt parallel_inclusive_scan(ThreadPool &pool, RandomIt first, RandomIt last, OutputIt d_first, BinaryOp op = BinaryOp())
+    {
+        using value_t = typename std::iterator_traits<RandomIt>::value_type;
+        std::size_t n = static_cast<std::size_t>(last - first);
+        if (n == 0)
+            return d_first;
+        std::size_t chunk = parallel_detail::chunk_size<value_t>(n, parallel_detail::participants(pool));
+        std::size_t count = (n + chunk - 1) / chunk;
+        std::vector<value_t> totals(count);
+        parallel_detail::run_chunks(pool, count, [&](std::size_t index)
+        {
+            std::size_t begin = index * chunk, end = std::min(n, begin + chunk);
+            std::inclusive_scan(first + begin, first + end, d_first + begin, op);
+            totals[index] = *(d_first + (end - 1));
+        });
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            totals[i] = op(totals[i - 1], totals[i]);
+        }
+        parallel_detail::run_chunks(pool, count - 1, [&](std::size_t index)
+        {
+            std::size_t begin = (index + 1) * chunk, end = std::min(n, begin + chunk);
+            const value_t &offset = totals[index];
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                *(d_first + i) = op(offset, *(d_first + i));
+            }
+        });
+        return d_first + n;
+    }
+
+    /*
+    parallel_sort先将区间划分为与参与线程数量相同的段并分别用std::sort排序,
+    然后逐轮两两合并相邻的有序段,每一轮中的合并并行执行,共log2(段数)轮
+    */
+    template <typename RandomIt, typename Compare = std::less<>>
+    void parallel_sort(ThreadPool &pool, RandomIt first, RandomIt last, Compare comp = Compare())
+    {
+        using value_t = typename std::iterator_traits<RandomIt>::value_type;
+        std::size_t n = static_cast<std::size_t>(last - first);
+        std::size_t runs = parallel_detail::participants(pool);
+        std::size_t min_run = parallel_detail::cache_bytes / std::max<std::size_t>(sizeof(value_t), 1);
+        runs = std::min(runs, std::max<std::size_t>(n / min_run, 1)); // 数据量很小时不值得并行
+        if (runs <= 1)
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+        std::vector<std::size_t> bounds(runs + 1);
+        for (std::size_t i = 0; i <= runs; ++i)
+        {
+            bounds[i] = n * i / runs;
+        }
+        parallel_detail::run_chunks(pool, runs, [&](std::size_t index)
+        {
+            std::sort(first + bounds[index], first + bounds[index + 1], comp);
+        });
+        for (std::size_t width = 1; width < runs; width *= 2)
+        {
+            std::size_t pairs = (runs + 2 * width - 1) / (2 * width);
+            parallel_detail::run_chunks(pool, pairs, [&](std::size_t index)
+            {
+                std::size_t left = index * 2 * width;
+                std::size_t mid = std::min(left + width, runs);
+                std::size_t right = std::min(left + 2 * width, runs);
+                if (mid < right)
+                {
+                    std::inplace_merge(first + bounds[left], first + bounds[mid], first + bounds[right], comp);
+                }
+            });
+        }
+    }
+};
+
+#endif // PARALLELALGORITHM_H
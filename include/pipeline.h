@@ -0,0 +1,339 @@
+/**
+ * @file pipeline.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 基于线程池的多阶段流水线,支持串行有序、串行无序与并行三种阶段,并限制同时处理的数据项数量
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <mutex>
+#include <utility>
+#include <algorithm>
+#include <queue>
+#include <memory>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include "threadPool.h"
+
+namespace my_thread_poll
+{
+    enum class stage_mode : std::int8_t
+    {
+        SERIAL_IN_ORDER = 0,     // 串行有序:同一时刻只处理一个数据项,并且按照数据项产生的顺序处理
+        SERIAL_OUT_OF_ORDER = 1, // 串行无序:同一时刻只处理一个数据项,处理顺序不限
+        PARALLEL = 2             // 并行:多个数据项可以同时处理
+    };
+
+    /*
+    Pipeline的工作方式如下:
+    1.数据源阶段串行地将数据写入一个空闲的令牌(token),令牌数量即同时处理的数据项上限,令牌在运行前一次性分配并循环使用
+    2.产生数据的工作线程携带该令牌依次执行后续所有阶段,使数据项尽量停留在同一个核心上,
+    同时若还有空闲令牌,则向线程池提交新的数据源任务,让其他工作线程继续产生数据
+    3.串行阶段正在处理其他数据项(或串行有序阶段还未轮到该数据项)时,令牌暂存在该阶段中,当前工作线程直接返回;
+    串行阶段处理完一个数据项后,将下一个可以处理的暂存令牌作为新任务提交到线程池
+    4.令牌通过最后一个阶段后归还,并由当前工作线程继续执行数据源阶段
+    任意阶段抛出异常后数据源停止产生新数据,已产生的数据项跳过剩余阶段,run在全部令牌归还后重新抛出该异常
+    */
+    template <typename Item>
+    class Pipeline
+    {
+    private:
+        struct token_t
+        {
+            Item item;             // 数据项
+            std::size_t seq = 0;   // 数据项产生的顺序
+        };
+        struct stage_t
+        {
+            stage_mode mode;
+            std::function<void(Item &)> func;
+            std::mutex mutex;                   // 串行阶段的互斥锁
+            bool busy = false;                  // 串行阶段是否正在处理数据项
+            std::size_t next_seq = 0;           // 串行有序阶段下一个应处理的数据项
+            std::vector<token_t *> in_order;    // 串行有序阶段暂存的令牌,按seq对令牌数量取模存放
+            std::queue<token_t *> out_of_order; // 串行无序阶段暂存的令牌
+        };
+
+        ThreadPool &pool;
+        std::function<bool(Item &)> source_func;     // 数据源,返回false表示数据已经全部产生
+        std::vector<std::unique_ptr<stage_t>> stages; // 数据源之后的各个阶段
+        std::vector<token_t> tokens;                  // 令牌
+        std::vector<token_t *> free_tokens;           // 空闲令牌
+        std::mutex source_mutex;                      // 保护数据源与令牌状态
+        std::condition_variable done_cv;              // 流水线执行完毕的条件变量
+        bool source_busy = false;                     // 数据源阶段是否正在执行
+        bool exhausted = false;                       // 数据源是否已经结束
+        std::size_t next_seq = 0;                     // 下一个数据项的顺序
+        std::size_t in_flight = 0;                    // 正在处理的数据项数量
+        std::size_t pending_feeds = 0;                // 已提交但尚未开始执行的数据源任务数量
+        std::atomic<bool> stopped{false};             // 是否因为异常而停止
+        std::exception_ptr error;                     // 第一个异常
+
+        token_t *acquire_with_source_lock();                         // 取得数据源阶段与一个空闲令牌,无法取得时返回空
+        void start();                                                // 由schedule提交的数据源任务入口
+        void feed(token_t *token);                                   // 执行数据源阶段并携带数据项执行后续阶段
+        bool process(token_t *token, std::size_t stage, bool owned); // 从指定阶段开始处理数据项,返回false表示令牌被暂存
+        token_t *finish(token_t *token);                             // 归还令牌,并尝试取得数据源阶段以继续产生数据
+        void fail(std::exception_ptr e);                             // 记录异常并停止数据源
+        bool done_with_source_lock() const { return exhausted && in_flight == 0 && !source_busy && pending_feeds == 0; }
+        template <typename Func>
+        void schedule(Func func) // 提交到线程池,线程池不接收任务时在当前线程执行
+        {
+            try
+            {
+                pool.post(func);
+            }
+            catch (...)
+            {
+                func();
+            }
+        }
+
+    public:
+        explicit Pipeline(ThreadPool &pool) : pool(pool) {}
+        Pipeline(const Pipeline &) = delete;
+        Pipeline &operator=(const Pipeline &) = delete;
+
+        template <typename Func>
+        Pipeline &source(Func &&func) // 设置数据源,func签名为bool(Item&)
+        {
+            source_func = std::forward<Func>(func);
+            return *this;
+        }
+
+        template <typename Func>
+        Pipeline &stage(stage_mode mode, Func &&func) // 添加一个阶段,func签名为void(Item&)
+        {
+            auto st = std::make_unique<stage_t>();
+            st->mode = mode;
+            st->func = std::forward<Func>(func);
+            stages.push_back(std::move(st));
+            return *this;
+        }
+
+        void run(std::size_t max_tokens); // 执行流水线直到数据源结束且所有数据项处理完毕,不能在线程池的工作线程中调用
+    };
+
+    template <typename Item>
+    void Pipeline<Item>::run(std::size_t max_tokens)
+    {
+        max_tokens = std::max<std::size_t>(max_tokens, 1);
+        tokens = std::vector<token_t>(max_tokens);
+        free_tokens.clear();
+        for (auto &token : tokens)
+        {
+            free_tokens.push_back(&token);
+        }
+        for (auto &st : stages)
+        {
+            st->busy = false;
+            st->next_seq = 0;
+            st->in_order.assign(max_tokens, nullptr);
+        }
+        source_busy = false;
+        exhausted = !source_func;
+        next_seq = 0;
+        in_flight = 0;
+        pending_feeds = 1;
+        stopped.store(false);
+        error = nullptr;
+
+        schedule([this]() { start(); });
+        std::unique_lock<std::mutex> lock(source_mutex);
+        done_cv.wait(lock, [this]() { return done_with_source_lock(); });
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /*
+    流水线结束前,正在执行的线程总是持有以下之一:未归还的令牌、数据源阶段或未开始执行的数据源任务,
+    因此在释放它们之后不能再访问流水线对象,归还令牌与取得数据源阶段需要在同一次加锁中完成
+    */
+    template <typename Item>
+    typename Pipeline<Item>::token_t *Pipeline<Item>::acquire_with_source_lock()
+    {
+        if (exhausted || source_busy || free_tokens.empty())
+        {
+            if (done_with_source_lock())
+                done_cv.notify_all();
+            return nullptr;
+        }
+        source_busy = true;
+        token_t *token = free_tokens.back();
+        free_tokens.pop_back();
+        return token;
+    }
+
+    template <typename Item>
+    void Pipeline<Item>::start()
+    {
+        token_t *token;
+        {
+            std::lock_guard<std::mutex> lock(source_mutex);
+            --pending_feeds;
+            token = acquire_with_source_lock();
+        }
+        if (token)
+        {
+            feed(token);
+        }
+    }
+
+    template <typename Item>
+    void Pipeline<Item>::feed(token_t *token)
+    {
+        while (token)
+        {
+            bool produced = false;
+            if (!stopped.load())
+            {
+                try
+                {
+                    produced = source_func(token->item);
+                }
+                catch (...)
+                {
+                    fail(std::current_exception());
+                }
+            }
+            bool more = false;
+            {
+                std::lock_guard<std::mutex> lock(source_mutex);
+                source_busy = false;
+                if (!produced)
+                {
+                    exhausted = true;
+                    free_tokens.push_back(token);
+                    if (done_with_source_lock())
+                        done_cv.notify_all();
+                    return;
+                }
+                token->seq = next_seq++;
+                ++in_flight;
+                if (!free_tokens.empty())
+                {
+                    more = true;
+                    ++pending_feeds;
+                }
+            }
+            if (more) // 还有空闲令牌,由其他工作线程继续产生数据
+            {
+                schedule([this]() { start(); });
+            }
+            if (!process(token, 0, false))
+            {
+                return;
+            }
+            token = finish(token); // 当前工作线程继续产生下一个数据项
+        }
+    }
+
+    template <typename Item>
+    bool Pipeline<Item>::process(token_t *token, std::size_t index, bool owned)
+    {
+        for (; index < stages.size(); ++index, owned = false)
+        {
+            stage_t &st = *stages[index];
+            if (st.mode == stage_mode::PARALLEL)
+            {
+                if (!stopped.load())
+                {
+                    try
+                    {
+                        st.func(token->item);
+                    }
+                    catch (...)
+                    {
+                        fail(std::current_exception());
+                    }
+                }
+                continue;
+            }
+            if (!owned)
+            {
+                std::lock_guard<std::mutex> lock(st.mutex);
+                bool runnable = !st.busy && (st.mode == stage_mode::SERIAL_OUT_OF_ORDER || token->seq == st.next_seq);
+                if (!runnable) // 暂存令牌,由该阶段当前的处理者在完成后重新调度
+                {
+                    if (st.mode == stage_mode::SERIAL_IN_ORDER)
+                        st.in_order[token->seq % tokens.size()] = token;
+                    else
+                        st.out_of_order.push(token);
+                    return false;
+                }
+                st.busy = true;
+            }
+            if (!stopped.load())
+            {
+                try
+                {
+                    st.func(token->item);
+                }
+                catch (...)
+                {
+                    fail(std::current_exception());
+                }
+            }
+            token_t *next = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(st.mutex);
+                if (st.mode == stage_mode::SERIAL_IN_ORDER)
+                {
+                    ++st.next_seq;
+                    token_t *&slot = st.in_order[st.next_seq % tokens.size()];
+                    if (slot && slot->seq == st.next_seq)
+                    {
+                        next = std::exchange(slot, nullptr);
+                    }
+                }
+                else if (!st.out_of_order.empty())
+                {
+                    next = st.out_of_order.front();
+                    st.out_of_order.pop();
+                }
+                st.busy = next != nullptr; // 将该阶段直接交给下一个令牌,避免其他令牌插队
+            }
+            if (next)
+            {
+                schedule([this, next, index]()
+                {
+                    if (process(next, index, true))
+                        feed(finish(next));
+                });
+            }
+        }
+        return true;
+    }
+
+    template <typename Item>
+    typename Pipeline<Item>::token_t *Pipeline<Item>::finish(token_t *token)
+    {
+        std::lock_guard<std::mutex> lock(source_mutex);
+        free_tokens.push_back(token);
+        --in_flight;
+        return acquire_with_source_lock();
+    }
+
+    template <typename Item>
+    void Pipeline<Item>::fail(std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> lock(source_mutex);
+        if (!error)
+        {
+            error = e;
+        }
+        stopped.store(true);
+    }
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,400 @@
+/**
+ * @file poolFuture.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 线程池的future,共享状态与任务共用一次分配并以原子状态字同步;在工作线程上等待结果时执行其他排队中的任务,避免嵌套提交时工作线程全部阻塞导致死锁
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef POOLFUTURE_H
+#define POOLFUTURE_H
+
+#include <new>
+#include <chrono>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <type_traits>
+#include "threadPool.h"
+
+namespace my_thread_poll
+{
+    /*
+    pool_continuation是共享状态就绪后执行的回调,由when_all/when_any等组合器使用,
+    在写入结果的线程上执行,因此回调本身应当很短;next由共享状态用于把同一输入上登记的多个回调串成链表
+    */
+    struct pool_continuation
+    {
+        pool_continuation *next = nullptr; // 同一共享状态上登记的下一个回调
+
+        virtual void run() noexcept = 0;
+    protected:
+        ~pool_continuation() = default;
+    };
+
+    /*
+    pool_state_base是pool_future的共享状态中与结果类型无关的部分,与std::promise/std::future的区别:
+    1.使用一个原子状态字表示是否就绪,获取结果时不加锁,阻塞等待使用std::atomic::wait
+    2.使用引用计数管理生命周期:默认任务端与future端各持有一个引用
+    3.可以登记多个回调(侵入式链表),结果就绪时由写入结果的线程调用,组合等待多个future时无需占用等待线程;
+    同一个future先后参与多次组合(例如when_any结果中尚未就绪的输入再交给when_all)时,每次组合各自登记一个回调
+    */
+    class pool_state_base
+    {
+    public:
+        enum : std::uint32_t
+        {
+            EMPTY = 0,    // 结果尚未就绪
+            VALUE = 1,    // 已写入返回值
+            EXCEPTION = 2 // 已写入异常
+        };
+
+        std::atomic<std::uint32_t> state{EMPTY}; // 状态字
+        std::atomic<std::uint32_t> refs{2};      // 引用计数
+
+        pool_state_base() = default;
+        pool_state_base(const pool_state_base &) = delete;
+        pool_state_base &operator=(const pool_state_base &) = delete;
+
+        bool is_ready() const noexcept { return state.load(std::memory_order_acquire) != EMPTY; }
+
+        void wait() const noexcept // 阻塞到结果就绪
+        {
+            std::uint32_t current;
+            while ((current = state.load(std::memory_order_acquire)) == EMPTY)
+            {
+                state.wait(current, std::memory_order_acquire);
+            }
+        }
+
+        void then(pool_continuation *c) noexcept // 登记结果就绪后的回调,结果已发布时立即在当前线程调用
+        {
+            pool_continuation *head = continuation.load(std::memory_order_acquire);
+            do
+            {
+                if (head == fired())
+                {
+                    c->run();
+                    return;
+                }
+                c->next = head;
+            } while (!continuation.compare_exchange_weak(head, c, std::memory_order_acq_rel, std::memory_order_acquire));
+        }
+
+        void release() noexcept // 释放一个引用,引用归零时销毁共享状态
+        {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                destroy_state();
+            }
+        }
+
+    protected:
+        virtual void destroy_state() noexcept = 0; // 析构并归还整个共享状态
+        ~pool_state_base() = default;
+
+        void publish(std::uint32_t result) // 发布结果,唤醒等待者并执行已登记的回调;调用者需要在返回前持有一个引用
+        {
+            state.store(result, std::memory_order_release);
+            state.notify_all();
+            pool_continuation *c = continuation.exchange(fired(), std::memory_order_acq_rel);
+            while (c)
+            {
+                pool_continuation *next = c->next; // run可能释放回调节点所在的对象,先取出后继
+                c->run();
+                c = next;
+            }
+        }
+
+    private:
+        std::atomic<pool_continuation *> continuation{nullptr}; // 已登记回调链表的表头,结果发布后置为fired()
+
+        static pool_continuation *fired() noexcept // 表示结果已发布的标记
+        {
+            struct fired_t final : pool_continuation
+            {
+                void run() noexcept override {}
+            };
+            static fired_t marker;
+            return &marker;
+        }
+    };
+
+    template <typename T>
+    class pool_state : public pool_state_base
+    {
+    public:
+        using value_type = std::conditional_t<std::is_void_v<T>, char,
+                           std::conditional_t<std::is_reference_v<T>, std::remove_reference_t<T> *, T>>; // 引用保存为指针,void不保存
+
+        pool_state() {}
+
+        template <typename... V>
+        void set_value(V &&...v) // 写入返回值,只能调用一次
+        {
+            ::new (static_cast<void *>(&value)) value_type(std::forward<V>(v)...);
+            publish(VALUE);
+        }
+
+        void set_exception(std::exception_ptr e) // 写入异常,只能调用一次
+        {
+            error = std::move(e);
+            publish(EXCEPTION);
+        }
+
+        T take() // 取出结果,任务抛出的异常在这里重新抛出,调用前结果必须已经就绪
+        {
+            if (state.load(std::memory_order_acquire) == EXCEPTION)
+            {
+                std::rethrow_exception(error);
+            }
+            if constexpr (std::is_void_v<T>)
+                return;
+            else if constexpr (std::is_reference_v<T>)
+                return static_cast<T>(*value);
+            else
+                return std::move(value);
+        }
+
+    protected:
+        ~pool_state()
+        {
+            if (state.load(std::memory_order_relaxed) == VALUE)
+            {
+                value.~value_type();
+            }
+        }
+
+    private:
+        union
+        {
+            value_type value; // 返回值,只在状态为VALUE时有效
+        };
+        std::exception_ptr error; // 异常,只在状态为EXCEPTION时有效
+    };
+
+    /*
+    pool_task_state将共享状态与任务函数放在同一个slab块中,同时作为pooled_task的控制块,
+    因此每次提交只有一次分配;任务执行完毕(或未执行就被丢弃)后立即析构任务函数,
+    未执行就被丢弃时向future写入broken_promise异常
+    */
+    template <typename T, typename F>
+    class pool_task_state final : public pool_state<T>, public pooled_task::callable_base
+    {
+    private:
+        std::optional<F> func; // 已绑定参数的任务函数
+
+    public:
+        template <typename G>
+        explicit pool_task_state(G &&g) : func(std::in_place, std::forward<G>(g)) {}
+
+        template <typename G>
+        static pool_task_state *create(G &&g)
+        {
+            slab_allocator<pool_task_state> alloc;
+            pool_task_state *p = alloc.allocate(1);
+            try
+            {
+                ::new (static_cast<void *>(p)) pool_task_state(std::forward<G>(g));
+            }
+            catch (...)
+            {
+                alloc.deallocate(p, 1);
+                throw;
+            }
+            return p;
+        }
+
+        void invoke() override
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    (*func)();
+                    this->set_value();
+                }
+                else if constexpr (std::is_reference_v<T>)
+                {
+                    this->set_value(&(*func)());
+                }
+                else
+                {
+                    this->set_value((*func)());
+                }
+            }
+            catch (...)
+            {
+                this->set_exception(std::current_exception());
+            }
+        }
+
+        void destroy() noexcept override
+        {
+            func.reset();
+            if (!this->is_ready())
+            {
+                this->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+            this->release();
+        }
+
+    protected:
+        void destroy_state() noexcept override
+        {
+            slab_allocator<pool_task_state> alloc;
+            this->~pool_task_state();
+            alloc.deallocate(this, 1);
+        }
+    };
+
+    /*
+    pool_future_base封装"帮助等待"所需的线程池操作,模板之外的部分在poolFuture.cpp中实现
+    */
+    class pool_future_base
+    {
+    protected:
+        static constexpr std::chrono::microseconds max_help_pause{1000}; // 没有可执行任务时两次检查之间的最长等待时间
+
+        ThreadPool *pool = nullptr; // 提交任务的线程池
+
+        pool_future_base() noexcept = default;
+        explicit pool_future_base(ThreadPool *pool) noexcept : pool(pool) {}
+
+        bool on_worker_thread() const; // 当前线程是否为该线程池的工作线程
+        bool help() const;             // 在当前工作线程上执行一个排队中的任务,没有任务时返回false
+    };
+
+    /*
+    pool_future的等待方式如下:
+    1.在线程池外部的线程上调用get/wait时,通过std::atomic::wait阻塞在共享状态的状态字上
+    2.在该线程池的工作线程上调用时,结果未就绪前不断取出其他排队中的任务执行(包括所等待的任务本身),
+    没有可执行的任务时短暂休眠后再次检查,休眠时间从1微秒开始倍增,最长max_help_pause
+    因此即使线程池只有一个工作线程,任务中提交子任务并等待其结果也不会死锁
+    3.std::atomic::wait不支持超时,wait_for/wait_until同样采用倍增休眠的方式检查状态字
+    与std::future相同,get只能调用一次,调用后valid返回false
+    */
+    template <typename T>
+    class pool_future : private pool_future_base
+    {
+    private:
+        pool_state<T> *state = nullptr;
+
+        friend struct pool_future_access;
+
+        template <typename Pred>
+        bool wait_with_backoff(Pred expired) const // 帮助执行任务或休眠,直到结果就绪或expired返回true
+        {
+            bool helping = on_worker_thread();
+            std::chrono::microseconds pause(1);
+            while (!state->is_ready())
+            {
+                if (expired())
+                {
+                    return false;
+                }
+                if (helping && help())
+                {
+                    pause = std::chrono::microseconds(1);
+                    continue;
+                }
+                std::this_thread::sleep_for(pause);
+                pause = std::min(pause * 2, max_help_pause);
+            }
+            return true;
+        }
+
+    public:
+        pool_future() noexcept = default;
+        pool_future(ThreadPool *pool, pool_state<T> *state) noexcept : pool_future_base(pool), state(state) {}
+        pool_future(pool_future &&other) noexcept : pool_future_base(other.pool), state(std::exchange(other.state, nullptr)) {}
+        pool_future &operator=(pool_future &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (state)
+                    state->release();
+                pool = other.pool;
+                state = std::exchange(other.state, nullptr);
+            }
+            return *this;
+        }
+        pool_future(const pool_future &) = delete;
+        pool_future &operator=(const pool_future &) = delete;
+        ~pool_future()
+        {
+            if (state)
+                state->release();
+        }
+
+        bool valid() const noexcept { return state != nullptr; }
+        bool is_ready() const noexcept { return state->is_ready(); }
+
+        T get() // 获取结果,任务抛出的异常在这里重新抛出
+        {
+            wait();
+            struct release_guard
+            {
+                pool_state<T> *state;
+                ~release_guard() { state->release(); }
+            } guard{std::exchange(state, nullptr)};
+            return guard.state->take();
+        }
+
+        void wait() const
+        {
+            if (state->is_ready())
+                return;
+            if (!on_worker_thread())
+            {
+                state->wait();
+                return;
+            }
+            wait_with_backoff([]() { return false; });
+        }
+
+        template <typename Clock, typename Duration>
+        std::future_status wait_until(const std::chrono::time_point<Clock, Duration> &deadline) const
+        {
+            bool ready = wait_with_backoff([&deadline]() { return Clock::now() >= deadline; });
+            return ready ? std::future_status::ready : std::future_status::timeout;
+        }
+
+        template <typename Rep, typename Period>
+        std::future_status wait_for(const std::chrono::duration<Rep, Period> &timeout) const
+        {
+            return wait_until(std::chrono::steady_clock::now() + timeout);
+        }
+    };
+
+    /*
+    async与submit的区别在于返回pool_future:任务函数、参数与共享状态一起放在一个slab块中,
+    该块同时作为pooled_task的控制块加入任务队列,没有std::promise的互斥锁、条件变量与额外的结果对象分配
+    */
+    template <typename Func, typename... Args>
+    auto ThreadPool::async(Func &&f, Args &&...args) -> pool_future<decltype(f(args...))>
+    {
+        using return_type = decltype(f(args...));
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock();
+        auto bound = [func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable -> return_type
+        {
+            return func(bound_args...);
+        };
+        auto *state = pool_task_state<return_type, decltype(bound)>::create(std::move(bound));
+        pool_future<return_type> res(this, state);
+        push_task(pooled_task::adopt(state), true);
+        return res;
+    }
+};
+
+#endif // POOLFUTURE_H
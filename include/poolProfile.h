@@ -0,0 +1,113 @@
+/**
+ * @file poolProfile.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 线程池调度开销的编译期插桩:定义THREAD_POOL_PROFILE时按阶段累计每个线程的耗时,未定义时插桩点展开为空
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef POOLPROFILE_H
+#define POOLPROFILE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <cstddef>
+#if defined(THREAD_POOL_PROFILE) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace my_thread_poll
+{
+    namespace profile
+    {
+        enum phase_t : std::size_t // 插桩的阶段
+        {
+            SUBMIT = 0, // 提交的全部开销:打包任务、检查状态、加入队列与唤醒,覆盖所有公开的提交接口(submit、post、submit_to、submit_deadline、submit_class、async等)
+            ENQUEUE,    // 加入队列(分片、本地队列、截止时间堆、类别队列)时的加锁与入队
+            WAKEUP,     // 唤醒空闲的工作线程
+            DEQUEUE,    // 工作线程取出任务(本地队列、分片、类别、截止时间、窃取)
+            IDLE,       // 工作线程阻塞等待任务
+            EXECUTE,    // 执行任务,即用户代码(包括promise的设置)
+            PHASE_COUNT
+        };
+
+        struct phase_stats // 一个阶段的累计统计
+        {
+            std::uint64_t count = 0; // 进入该阶段的次数
+            std::uint64_t nanoseconds = 0; // 累计耗时
+        };
+
+        using report_t = std::array<phase_stats, PHASE_COUNT>;
+
+        report_t snapshot();               // 汇总所有线程(包括已经退出的线程)的计数
+        void reset();                      // 清零所有计数
+        void report(std::ostream &out);    // 按阶段输出次数、总耗时与平均耗时,以及平均每个任务的调度开销
+        const char *phase_name(phase_t phase);
+
+        inline std::uint64_t now() noexcept // 时间戳:x86上为时间戳计数器的周期数,其他平台为steady_clock的纳秒数
+        {
+#if defined(THREAD_POOL_PROFILE) && (defined(__x86_64__) || defined(__i386__))
+            return __rdtsc();
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        /*
+        thread_counters是每个线程独立的计数,只由所属线程写入,汇总时由其他线程读取,因此使用relaxed原子变量;
+        线程第一次记录时创建并登记,线程退出时将计数并入已退出线程的总和并注销
+        */
+        struct thread_counters
+        {
+            std::array<std::atomic<std::uint64_t>, PHASE_COUNT> count{};
+            std::array<std::atomic<std::uint64_t>, PHASE_COUNT> ticks{};
+
+            thread_counters();
+            ~thread_counters();
+            thread_counters(const thread_counters &) = delete;
+            thread_counters &operator=(const thread_counters &) = delete;
+
+            void add(phase_t phase, std::uint64_t elapsed) noexcept
+            {
+                count[phase].store(count[phase].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                ticks[phase].store(ticks[phase].load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+            }
+
+            static thread_counters &local()
+            {
+                static thread_local thread_counters counters;
+                return counters;
+            }
+        };
+
+        class scope // 在作用域结束时将经过的时间记入指定阶段
+        {
+        private:
+            phase_t phase;
+            std::uint64_t start;
+
+        public:
+            explicit scope(phase_t phase) noexcept : phase(phase), start(now()) {}
+            ~scope() { thread_counters::local().add(phase, now() - start); }
+            scope(const scope &) = delete;
+            scope &operator=(const scope &) = delete;
+        };
+    };
+};
+
+#define THREAD_POOL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define THREAD_POOL_PROFILE_CONCAT(a, b) THREAD_POOL_PROFILE_CONCAT_IMPL(a, b)
+#ifdef THREAD_POOL_PROFILE
+#define THREAD_POOL_PROFILE_SCOPE(phase) ::my_thread_poll::profile::scope THREAD_POOL_PROFILE_CONCAT(thread_pool_profile_scope_, __LINE__)(::my_thread_poll::profile::phase)
+#else
+#define THREAD_POOL_PROFILE_SCOPE(phase) ((void)0)
+#endif
+
+#endif // POOLPROFILE_H
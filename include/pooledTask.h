@@ -0,0 +1,145 @@
+/**
+ * @file pooledTask.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 只可移动的类型擦除任务包装,控制块由slab_allocator分配,用于替代任务队列中的std::function
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef POOLEDTASK_H
+#define POOLEDTASK_H
+
+#include <future>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include "slabAllocator.h"
+
+namespace my_thread_poll
+{
+    /*
+    pooled_task与std::function<void()>的区别:
+    1.只可移动,因此可以直接持有std::promise等只可移动对象,无需再用std::shared_ptr包装
+    2.控制块通过slab_allocator从当前线程的缓存中分配,稳态下不访问全局堆
+    */
+    class pooled_task
+    {
+    public:
+        struct callable_base // 控制块接口,自行管理生命周期的控制块(如pool_future的共享状态)可以直接继承并通过adopt接管
+        {
+            virtual void invoke() = 0;           // 执行任务
+            virtual void destroy() noexcept = 0; // 任务不再被持有时调用,析构并归还控制块
+        protected:
+            ~callable_base() = default;
+        };
+
+    private:
+
+        template <typename F>
+        struct callable final : callable_base
+        {
+            F func;
+            template <typename G>
+            explicit callable(G &&g) : func(std::forward<G>(g)) {}
+            void invoke() override { func(); }
+            void destroy() noexcept override
+            {
+                slab_allocator<callable> alloc;
+                this->~callable();
+                alloc.deallocate(this, 1);
+            }
+        };
+
+        callable_base *impl = nullptr;
+
+    public:
+        pooled_task() noexcept = default;
+
+        template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, pooled_task>>>
+        pooled_task(F &&f)
+        {
+            using callable_t = callable<std::decay_t<F>>;
+            slab_allocator<callable_t> alloc;
+            callable_t *p = alloc.allocate(1);
+            try
+            {
+                ::new (static_cast<void *>(p)) callable_t(std::forward<F>(f));
+            }
+            catch (...)
+            {
+                alloc.deallocate(p, 1);
+                throw;
+            }
+            impl = p;
+        }
+
+        static pooled_task adopt(callable_base *impl) noexcept // 接管已经构造好的控制块,不再额外分配
+        {
+            pooled_task task;
+            task.impl = impl;
+            return task;
+        }
+
+        pooled_task(pooled_task &&other) noexcept : impl(std::exchange(other.impl, nullptr)) {}
+
+        pooled_task &operator=(pooled_task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                impl = std::exchange(other.impl, nullptr);
+            }
+            return *this;
+        }
+
+        pooled_task(const pooled_task &) = delete;
+        pooled_task &operator=(const pooled_task &) = delete;
+
+        ~pooled_task() { reset(); }
+
+        void reset() noexcept
+        {
+            if (impl)
+            {
+                std::exchange(impl, nullptr)->destroy();
+            }
+        }
+
+        explicit operator bool() const noexcept { return impl != nullptr; }
+
+        void operator()() { impl->invoke(); }
+    };
+
+    template <typename Func, typename... Args>
+    auto package_task(Func &&f, Args &&...args) -> std::pair<pooled_task, std::future<decltype(f(args...))>> // 将任务与promise打包为pooled_task,promise的共享状态同样来自slab_allocator
+    {
+        using return_type = decltype(f(args...));
+        std::promise<return_type> promise(std::allocator_arg, slab_allocator<char>());
+        std::future<return_type> res = promise.get_future();
+        pooled_task task([func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args), promise = std::move(promise)]() mutable
+        {
+            try
+            {
+                if constexpr (std::is_void_v<return_type>)
+                {
+                    func(bound_args...);
+                    promise.set_value();
+                }
+                else
+                {
+                    promise.set_value(func(bound_args...));
+                }
+            }
+            catch (...)
+            {
+                promise.set_exception(std::current_exception());
+            }
+        });
+        return {std::move(task), std::move(res)};
+    }
+};
+
+#endif // POOLEDTASK_H
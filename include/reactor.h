@@ -0,0 +1,80 @@
+/**
+ * @file reactor.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 基于epoll/eventfd的反应器,监听文件描述符的就绪事件,并将回调作为任务提交到线程池执行
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <sys/epoll.h>
+#include "threadPool.h"
+
+namespace my_thread_poll
+{
+    /*
+    Reactor的工作方式如下:
+    1.反应器线程阻塞在epoll_wait上,不占用线程池的工作线程,I/O任务无需在工作线程中阻塞于read/accept
+    2.文件描述符以EPOLLONESHOT方式注册,就绪后将回调提交到线程池执行,回调执行完毕后再重新注册,
+    因此同一个文件描述符的回调不会并发执行
+    3.停止反应器时通过eventfd唤醒反应器线程
+    4.线程池不接收新任务(暂停、关闭)时,回调直接在反应器线程上执行
+    回调的参数为文件描述符与就绪的事件(EPOLLIN、EPOLLOUT等)
+    */
+    class Reactor
+    {
+    public:
+        using callback_t = std::function<void(int fd, std::uint32_t events)>;
+
+        explicit Reactor(ThreadPool &pool);
+        ~Reactor();
+        Reactor(const Reactor &) = delete;
+        Reactor &operator=(const Reactor &) = delete;
+
+        void add(int fd, std::uint32_t events, callback_t callback); // 注册文件描述符,events为EPOLLIN、EPOLLOUT等事件的组合
+        void modify(int fd, std::uint32_t events);                   // 修改监听的事件
+        void remove(int fd);                                         // 取消注册,不会关闭文件描述符;正在执行的回调不会被中断
+        int add_timer(std::chrono::nanoseconds interval, callback_t callback, bool repeat = true); // 创建并注册timerfd,返回其文件描述符,回调中无需读取timerfd
+        void remove_timer(int timer_fd);                             // 取消注册并关闭add_timer创建的timerfd
+        void stop();                                                 // 停止反应器线程,已提交的回调仍会执行
+
+    private:
+        struct handler_t
+        {
+            callback_t callback;      // 就绪回调
+            std::uint32_t events;     // 监听的事件
+            bool is_timer = false;    // 是否为add_timer创建的timerfd,回调前由反应器读取超时次数,注册后不再修改
+        };
+        struct state_t // 反应器的共享状态,由反应器与已提交的回调任务共同持有,最后一个持有者关闭epoll与eventfd
+        {
+            ThreadPool *pool;
+            int epoll_fd = -1;
+            int event_fd = -1;
+            std::mutex mutex;                                              // 保护handlers
+            std::unordered_map<int, std::shared_ptr<handler_t>> handlers;  // 已注册的文件描述符
+            std::atomic<bool> stopping{false};
+            ~state_t();
+        };
+        std::shared_ptr<state_t> state;
+        std::thread thread; // 反应器线程
+
+        void add_handler(int fd, std::shared_ptr<handler_t> handler);                          // 注册文件描述符及其处理器
+        void run();                                                                            // 反应器线程的循环
+        static void dispatch(const std::shared_ptr<state_t> &state, int fd, std::uint32_t events); // 执行回调并重新注册
+    };
+};
+
+#endif // REACTOR_H
@@ -0,0 +1,120 @@
+/**
+ * @file slabAllocator.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 线程池使用的按线程缓存的slab分配器,用于任务控制块、future共享状态以及任务队列节点的分配
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H
+
+#include <new>
+#include <atomic>
+#include <limits>
+#include <vector>
+#include <cstddef>
+
+namespace my_thread_poll
+{
+    /*
+    slab_cache是每个线程私有的小对象缓存,工作方式如下:
+    1.按照16,32,...,4096字节划分大小类,每个大小类从64KB的内存块中切分出固定大小的块
+    2.每个块前有一个块头,记录块所属的缓存与大小类,因此可以在任意线程上释放
+    3.由所属线程释放的块直接放入本地空闲链表;由其他线程释放的块压入所属缓存的远程空闲链表(无锁栈),
+    所属线程在本地空闲链表耗尽时一次性取回全部远程空闲块
+    4.缓存使用引用计数管理生命周期:所属线程持有一个引用,每个未释放的块持有一个引用,
+    线程退出后缓存会在最后一个块被释放时销毁
+    超过4096字节的请求直接交给全局堆
+    */
+    class slab_cache
+    {
+    public:
+        static constexpr std::size_t block_align = alignof(std::max_align_t); // 块的对齐要求
+        static constexpr std::size_t min_block_size = 16;                     // 最小大小类
+        static constexpr std::size_t max_block_size = 4096;                   // 最大大小类,超过该大小直接使用全局堆
+        static constexpr std::size_t class_count = 9;                         // 大小类的数量:16,32,...,4096
+        static constexpr std::size_t chunk_size = 64 * 1024;                  // 每次向全局堆申请的内存块大小
+
+        static void *allocate(std::size_t size);    // 从当前线程的缓存中分配内存
+        static void deallocate(void *p) noexcept;   // 释放内存,可以在任意线程上调用
+        static slab_cache &local();                 // 获取当前线程的缓存
+
+    private:
+        struct block_header // 块头,位于每个块之前
+        {
+            slab_cache *owner;      // 所属缓存,为空表示该块直接来自全局堆
+            std::size_t size_class; // 所属大小类
+        };
+        struct free_block // 空闲块,复用块的数据区域存储链表指针
+        {
+            free_block *next;
+        };
+        struct alignas(64) size_class_t // 按缓存行对齐,避免远程释放时不同大小类之间的伪共享
+        {
+            free_block *local_free = nullptr;                // 本地空闲链表,只由所属线程访问
+            std::atomic<free_block *> remote_free{nullptr};  // 远程空闲链表,由其他线程压入
+            char *bump = nullptr;                            // 当前内存块中未切分区域的起点
+            char *bump_end = nullptr;                        // 当前内存块中未切分区域的终点
+        };
+        static_assert(sizeof(block_header) % block_align == 0, "block header must keep payload aligned");
+
+        size_class_t classes[class_count]; // 各个大小类
+        std::vector<char *> chunks;        // 向全局堆申请的内存块,缓存销毁时统一释放
+        std::atomic<std::size_t> refs{1};  // 引用计数:所属线程 + 未释放的块
+
+        slab_cache() = default;
+        ~slab_cache();
+        slab_cache(const slab_cache &) = delete;
+        slab_cache &operator=(const slab_cache &) = delete;
+
+        void *allocate_block(std::size_t index); // 从指定大小类中分配一个块
+        void release() noexcept;                 // 释放一个引用,引用归零时销毁缓存
+        static std::size_t class_index(std::size_t size) noexcept;
+
+        friend struct slab_cache_holder;
+    };
+
+    /*
+    slab_allocator是符合标准库要求的分配器,将分配请求转发给当前线程的slab_cache,
+    用于std::promise的共享状态、pooled_task的控制块以及任务队列的节点
+    */
+    template <typename T>
+    class slab_allocator
+    {
+    public:
+        using value_type = T;
+
+        slab_allocator() noexcept = default;
+        template <typename U>
+        slab_allocator(const slab_allocator<U> &) noexcept {}
+
+        T *allocate(std::size_t n)
+        {
+            if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+                throw std::bad_array_new_length();
+            if constexpr (alignof(T) > slab_cache::block_align)
+                return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+            else
+                return static_cast<T *>(slab_cache::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, std::size_t) noexcept
+        {
+            if constexpr (alignof(T) > slab_cache::block_align)
+                ::operator delete(p, std::align_val_t(alignof(T)));
+            else
+                slab_cache::deallocate(p);
+        }
+
+        template <typename U>
+        bool operator==(const slab_allocator<U> &) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const slab_allocator<U> &) const noexcept { return false; }
+    };
+};
+
+#endif // SLABALLOCATOR_H
@@ -0,0 +1,124 @@
+/**
+ * @file strand.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief 基于线程池的串行执行器,保证提交到同一个Strand的任务按提交顺序逐个执行
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef STRAND_H
+#define STRAND_H
+
+#include <mutex>
+#include <algorithm>
+#include <queue>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "threadPool.h"
+
+namespace my_thread_poll
+{
+    /*
+    Strand(串行执行器)的工作方式如下:
+    1.任务先放入Strand自身的队列,如果Strand当前没有被调度,则向线程池提交一个排空任务
+    2.排空任务在工作线程上按顺序逐个执行Strand队列中的任务,同一时刻最多只有一个排空任务存在,
+    因此同一个Strand中的任务不会并发执行,也无需在任务内部加锁
+    3.队列为空时排空任务结束并清除调度标记,Strand为空时不占用任何工作线程
+    4.每次最多连续执行batch_size个任务,之后重新提交排空任务,避免长时间占用一个工作线程
+    Strand对象可以复制,副本共享同一个队列
+    */
+    class Strand
+    {
+    private:
+        static constexpr std::size_t batch_size = 64; // 排空任务一次最多执行的任务数量
+        struct state_t
+        {
+            ThreadPool *pool;                 // 执行任务的线程池
+            std::mutex mutex;                 // 保护队列与调度标记
+            ThreadPool::task_queue_t queue;   // 等待执行的任务
+            bool scheduled = false;           // 是否已经向线程池提交了排空任务
+            explicit state_t(ThreadPool *pool) : pool(pool) {}
+        };
+        std::shared_ptr<state_t> state;
+
+        void push(pooled_task &&task);                          // 将任务放入队列,必要时调度排空任务
+        static void drain(const std::shared_ptr<state_t> &state); // 在工作线程上按顺序执行队列中的任务
+
+    public:
+        explicit Strand(ThreadPool &pool);
+        template <typename Func, typename... Args>
+        auto submit(Func &&f, Args &&...args) -> std::future<decltype(f(args...))>; // 提交任务并返回future
+        template <typename Func, typename... Args>
+        void post(Func &&f, Args &&...args);                                           // 提交任务,异常交给线程池的异常处理函数
+    };
+
+    template <typename Func, typename... Args>
+    auto Strand::submit(Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+    {
+        auto [task, res] = package_task(std::forward<Func>(f), std::forward<Args>(args)...);
+        push(std::move(task));
+        return std::move(res);
+    }
+
+    template <typename Func, typename... Args>
+    void Strand::post(Func &&f, Args &&...args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+        {
+            push(pooled_task(std::forward<Func>(f)));
+        }
+        else
+        {
+            push(pooled_task([func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable
+            {
+                func(bound_args...);
+            }));
+        }
+    }
+
+    /*
+    StrandGroup持有固定数量的Strand,按键的哈希值将任务分配到对应的Strand上,
+    键相同的任务总是按提交顺序串行执行,键不同的任务可以并行执行
+    */
+    template <typename Key, typename Hash = std::hash<Key>>
+    class StrandGroup
+    {
+    private:
+        std::vector<Strand> strands;
+        Hash hasher;
+
+    public:
+        StrandGroup(ThreadPool &pool, std::size_t strand_count) // strand_count为0时取1
+        {
+            strand_count = std::max<std::size_t>(strand_count, 1);
+            strands.reserve(strand_count);
+            for (std::size_t i = 0; i < strand_count; ++i)
+            {
+                strands.emplace_back(pool);
+            }
+        }
+
+        Strand &strand_for(const Key &key) // 获取键对应的Strand
+        {
+            return strands[hasher(key) % strands.size()];
+        }
+
+        template <typename Func, typename... Args>
+        auto submit_ordered(const Key &key, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+        {
+            return strand_for(key).submit(std::forward<Func>(f), std::forward<Args>(args)...);
+        }
+
+        template <typename Func, typename... Args>
+        void post_ordered(const Key &key, Func &&f, Args &&...args)
+        {
+            strand_for(key).post(std::forward<Func>(f), std::forward<Args>(args)...);
+        }
+    };
+};
+
+#endif // STRAND_H
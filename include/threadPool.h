@@ -14,17 +14,33 @@
 
 #include <list>
 #include <queue>
+#include <mutex>
+#include <thread>
 #include <future>
 #include <atomic>
+#include <chrono>
+#include <vector>
 #include <cstdint>
 #include <semaphore>
+#include <optional>
 #include <functional>
 #include <shared_mutex>
+#include <memory_resource>
 #include <condition_variable>
+#include "pooledTask.h"
+#include "poolProfile.h"
 
 namespace my_thread_poll
 {
+    class deadline_expired_error : public std::runtime_error // 开启过期丢弃时,已过截止时间的任务通过future抛出该异常
+    {
+    public:
+        deadline_expired_error() : std::runtime_error("ThreadPool task deadline expired") {}
+    };
 
+    class Reactor;
+    template <typename T>
+    class pool_future;
     class ThreadPool
     {
     private:
@@ -38,15 +54,103 @@ namespace my_thread_poll
             SHUTDOWN = 3
         }; // 线程池的状态: 已终止:-1,正在终止:0,正在运行:1,已暂停:2,等待线程池中任务完成,但是不接收新任务:3
         std::atomic<status_t> status;                    // 线程池的状态
-        std::atomic<std::size_t> max_task_count;         // 线程池中任务的最大数量
+        std::atomic<std::size_t> max_task_count;         // 默认类别(分片队列)中任务的最大数量,为0时不限制
         std::shared_mutex status_mutex;                  // 线程池状态互斥锁
         std::shared_mutex task_queue_mutex;              // 任务队列的互斥锁
         std::shared_mutex worker_lists_mutex;            // 工作线程列表的互斥锁
         std::condition_variable_any task_queue_cv;       // 任务队列的条件变量
         std::condition_variable_any task_queue_cv_full;  // 任务队列满的条件变量
         std::condition_variable_any task_queue_cv_empty; // 任务队列空的条件变量
-        std::queue<std::function<void()>> task_queue;    // 任务队列,其中存储待执行的任务
+        using task_queue_t = std::queue<pooled_task, std::deque<pooled_task, slab_allocator<pooled_task>>>;
+        struct shard_task_t                              // 分片中的任务
+        {
+            pooled_task task;                            // 任务
+            std::chrono::steady_clock::time_point enqueue_time; // 加入分片的时间,只在开启准入控制时记录,否则为零
+            bool sheddable;                              // 过载时是否允许丢弃,只有调用者能通过future得知丢弃的提交才允许
+        };
+        using shard_queue_t = std::queue<shard_task_t, std::deque<shard_task_t, slab_allocator<shard_task_t>>>;
+        struct alignas(64) task_shard                    // 任务队列分片,按缓存行对齐避免相邻分片之间的伪共享
+        {
+            std::mutex mutex;                            // 分片的互斥锁
+            std::atomic<std::size_t> size{0};            // 分片中的任务数量,用于扫描时跳过空分片
+            shard_queue_t queue;                         // 分片中存储的待执行任务
+            std::size_t submitted = 0;                   // 加入该分片的任务数量,受mutex保护
+            std::size_t executed = 0;                    // 从该分片取出的任务数量,受mutex保护
+        };
+        struct alignas(64) task_class_t                  // 任务类别,用于多个租户共享线程池时按权重分配执行机会
+        {
+            std::mutex mutex;                            // 类别队列的互斥锁
+            std::atomic<std::size_t> size{0};            // 类别队列中的任务数量
+            task_queue_t queue;                          // 类别队列,类别0使用共享的任务队列分片,不使用该队列
+            std::atomic<std::size_t> weight{1};          // 权重,每轮调度中该类别最多连续取出weight个任务
+            std::atomic<std::size_t> max_task_count{0};  // 类别队列中任务的最大数量,为0时不限制
+            std::atomic<std::size_t> rejected{0};        // 因队列已满被拒绝的任务数量
+            std::size_t submitted = 0;                   // 加入类别队列的任务数量,受mutex保护
+            std::size_t executed = 0;                    // 从类别队列取出的任务数量,受mutex保护
+        };
+        const std::size_t shard_count;                   // 任务队列分片数量
+        std::unique_ptr<task_shard[]> task_shards;       // 任务队列分片,生产者按线程id哈希选择分片
+        std::atomic<std::size_t> next_home_shard{0};     // 为新建工作线程分配所属分片的计数器
+        std::atomic<std::size_t> task_count{0};          // 所有分片与类别队列中的任务总数
+        struct deadline_task_t                           // 带截止时间的任务
+        {
+            std::chrono::steady_clock::time_point deadline; // 截止时间
+            std::uint64_t seq;                           // 同一分片内的提交顺序,截止时间相同时先提交的先执行
+            pooled_task task;                            // 任务
+        };
+        struct deadline_later                            // 堆的比较函数,使截止时间最早的任务位于堆顶
+        {
+            bool operator()(const deadline_task_t &a, const deadline_task_t &b) const
+            {
+                return a.deadline > b.deadline || (a.deadline == b.deadline && a.seq > b.seq);
+            }
+        };
+        struct alignas(64) deadline_shard                // 截止时间任务的分片,每个分片是一个按截止时间排序的小顶堆
+        {
+            std::mutex mutex;                            // 分片的互斥锁
+            std::vector<deadline_task_t, slab_allocator<deadline_task_t>> heap; // 小顶堆
+            std::atomic<std::chrono::steady_clock::rep> earliest{std::chrono::steady_clock::time_point::max().time_since_epoch().count()}; // 堆顶任务的截止时间,空堆为最大值,供工作线程不加锁地选择分片
+            std::uint64_t next_seq = 0;                  // 下一个任务的提交顺序
+        };
+        std::unique_ptr<deadline_shard[]> deadline_shards; // 截止时间任务的分片,数量与任务队列分片相同
+        std::atomic<std::size_t> deadline_task_count{0}; // 所有截止时间分片中的任务数量
+        std::atomic<bool> drop_expired{false};           // 是否丢弃已过截止时间的任务
+        std::atomic<std::size_t> expired_task_count{0};  // 因过期被丢弃的任务数量
+        std::atomic<std::chrono::steady_clock::rep> admission_target{0};   // 准入控制的目标排队时间,为0时关闭
+        std::atomic<std::chrono::steady_clock::rep> admission_interval{0}; // 准入控制的统计区间
+        std::atomic<bool> admission_shed{false};         // 过载时是否丢弃排队时间超过目标的任务
+        std::atomic<std::chrono::steady_clock::rep> admission_window_start{0}; // 当前统计区间的开始时间
+        std::atomic<std::chrono::steady_clock::rep> admission_window_min{std::chrono::steady_clock::duration::max().count()}; // 当前统计区间内的最小排队时间
+        std::atomic<bool> overloaded{false};             // 上一个统计区间的最小排队时间是否超过目标,过载时拒绝新任务
+        std::atomic<std::size_t> shed_task_count{0};     // 因过载被丢弃的排队任务数量
+        std::unique_ptr<task_class_t[]> task_classes;    // 任务类别,类别0为默认类别,对应submit/post提交到分片中的任务
+        std::atomic<std::size_t> task_class_count{1};    // 已创建的任务类别数量
+        std::mutex task_class_mutex;                     // 创建任务类别时的互斥锁
+        std::mutex drr_mutex;                            // 赤字轮询调度状态的互斥锁,只在存在多个任务类别时使用
+        std::size_t drr_current = 0;                     // 当前轮到的任务类别
+        std::size_t drr_deficit = 0;                     // 当前类别在本轮中还可以取出的任务数量
+        std::atomic<std::size_t> idle_worker_count{0};   // 阻塞在task_queue_cv上的工作线程数量
+        std::atomic<std::size_t> empty_waiter_count{0};  // 阻塞在task_queue_cv_empty上的线程数量
+        std::atomic<std::size_t> local_task_count{0};    // 所有工作线程本地队列中的任务总数
+        std::atomic<std::chrono::steady_clock::rep> steal_delay; // 本地队列中的任务等待多久之后允许被其他工作线程窃取
         std::list<worker_thread> worker_lists;           // 工作线程列表
+        std::vector<worker_thread *> worker_index;       // 按下标访问工作线程,与worker_lists的顺序一致,受worker_lists_mutex保护
+        std::mutex compensation_mutex;                   // 补偿线程列表的互斥锁,不与worker_lists_mutex共用,避免与增删线程时的等待形成死锁
+        std::list<worker_thread> compensation_workers;   // 补偿线程,工作线程进入阻塞区时临时创建,不参与submit_to的下标分配
+        std::size_t active_compensation_count = 0;       // 尚未被要求退出的补偿线程数量,受compensation_mutex保护
+        std::atomic<std::size_t> blocked_worker_count{0};// 正处于阻塞区中的工作线程数量
+        std::atomic<std::size_t> max_compensation_count; // 补偿线程数量上限
+        static thread_local worker_thread *current_worker; // 当前线程对应的工作线程,非工作线程为空
+        std::atomic<std::size_t> exit_epoch{0};          // 已经退出的工作线程(包括补偿线程)累计数量,每个线程退出时增加并唤醒等待者
+        std::atomic<std::chrono::steady_clock::rep> teardown_time{0}; // 最近一次terminate_for或析构等待工作线程退出所用的时间
+        std::atomic<std::size_t> lazy_thread_count{0};   // 延迟启动模式下尚未启动的工作线程数量,受worker_lists_mutex保护修改
+        bool lazy_start = false;                         // 是否为延迟启动模式,构造后不再修改;该模式下add_thread同样只增加尚未启动的线程数量
+        std::atomic<std::size_t> arena_size{64 * 1024};  // 每个工作线程内存池初始缓冲区的大小
+        std::atomic<std::pmr::memory_resource *> arena_upstream{std::pmr::new_delete_resource()}; // 内存池初始缓冲区耗尽后的上游内存资源
+        std::shared_mutex exception_handler_mutex;       // 异常处理函数的互斥锁
+        std::function<void(std::exception_ptr)> exception_handler; // 任务抛出未捕获异常时的处理函数,为空时输出到标准错误
+        std::mutex reactor_mutex;                        // 创建反应器时的互斥锁
+        std::unique_ptr<Reactor> reactor;                // 反应器,首次调用get_reactor时创建
         // 考虑到为了确保线程池的唯一性和安全性,禁止使用拷贝赋值与移动赋值
         ThreadPool(ThreadPool &) = delete;
         ThreadPool &operator=(ThreadPool &) = delete;
@@ -57,24 +161,115 @@ namespace my_thread_poll
         void resume_with_status_lock();                           // 恢复线程池
         void shutdown_with_status_lock();                         // 立刻关闭线程池
         void shutdown_with_wait_status_lock(bool wait_for_tasks); // 等待任务执行完毕关闭线程池
+        std::vector<pooled_task> shutdown_until_with_status_lock(std::chrono::steady_clock::time_point deadline); // 在截止时间前等待任务执行完毕,然后关闭线程池并返回剩余任务
         void terminate_with_status_lock();                        // 终止线程池
         void wait_with_status_lock();                             // 等待所有任务执行完毕
+        void check_submit_with_status_lock(std::size_t class_id = 0, bool shard_queue = true); // 检查线程池当前是否接收提交到指定类别的新任务,不接收时抛出异常;过载拒绝只作用于加入分片的提交
+        void push_task(pooled_task &&task, bool sheddable = false); // 将任务加入当前线程对应的分片并唤醒一个工作线程,sheddable为true时过载期间允许丢弃
+        bool pop_task(worker_thread *worker, pooled_task &task);  // 依次从本地队列、共享任务(分片与类别队列)中取出一个任务,最后尝试窃取其他工作线程的本地任务
+        bool pop_shard_task(worker_thread *worker, pooled_task &task); // 从所属分片开始依次扫描各个分片取出一个任务
+        bool pop_class_task(std::size_t class_id, pooled_task &task);  // 从指定类别队列中取出一个任务
+        bool pop_weighted_task(worker_thread *worker, pooled_task &task); // 按赤字轮询在各个类别之间选择并取出一个任务
+        void push_class_task(std::size_t class_id, pooled_task &&task, bool sheddable = false); // 将任务加入指定类别队列,类别0的任务加入分片
+        void notify_one_worker();                                 // 有空闲线程时唤醒其中一个
+        void push_deadline_task(std::chrono::steady_clock::time_point deadline, pooled_task &&task); // 将任务加入当前线程对应的截止时间分片
+        bool pop_deadline_task(pooled_task &task);                // 取出截止时间最早的任务
+        bool drop_if_expired(std::chrono::steady_clock::time_point deadline); // 开启过期丢弃且任务已过截止时间时返回true
+        bool admission_sample(std::chrono::steady_clock::time_point enqueue_time, bool sheddable); // 记录取出任务的排队时间并更新过载状态,分片取空时退出过载,需要丢弃该任务时返回true
+        std::size_t get_shard_task_count();                       // 所有分片中的任务数量(不包括类别队列与截止时间分片)
+        bool steal_task(worker_thread *worker, pooled_task &task);// 窃取其他工作线程本地队列中等待超过steal_delay的任务
+        void push_local_task(std::size_t worker_index, pooled_task &&task); // 将任务加入指定工作线程的本地队列
+        void rebuild_worker_index();                              // 在持有worker_lists_mutex时重建worker_index
+        void notify_all_workers();                                // 唤醒所有阻塞在任务队列上的工作线程
+        void start_lazy_worker();                                 // 延迟启动模式下没有空闲线程时启动一个工作线程
+        bool begin_blocking();                                    // 当前工作线程进入阻塞区,必要时创建补偿线程,当前线程不是工作线程时返回false
+        void end_blocking();                                      // 当前工作线程离开阻塞区,补偿线程多于阻塞的工作线程时让一个补偿线程退出
+        void reap_compensation_workers();                         // 回收已经退出的补偿线程
+        bool wait_workers_exit_until(std::chrono::steady_clock::time_point deadline); // 等待所有工作线程退出,超过截止时间返回false
+        void reap_exited_workers();                               // 回收已经退出的工作线程与补偿线程,尚未退出的保留到析构时回收
+        bool is_current_worker();                                 // 当前线程是否为该线程池的工作线程(包括补偿线程)
+        bool run_pending_task();                                  // 在当前工作线程上取出并执行一个排队中的任务,线程池暂停或终止时不执行
+        void notify_empty_waiters();                              // 任务队列变为空时唤醒等待任务完成的线程
+        void handle_exception(std::exception_ptr e);              // 处理任务执行时抛出的异常
+        friend class Strand;
+        friend class Reactor;
+        friend class pool_future_base;
     public:
-        ThreadPool(std::size_t inital_thread_count,std::size_t max_task_count=0); // 构造函数
+        ThreadPool(std::size_t inital_thread_count,std::size_t max_task_count=0,std::size_t shard_count=1,bool lazy_start=false); // 构造函数,shard_count为0时分片数量取初始线程数量;lazy_start为true时工作线程在任务到来时才逐个启动
         ~ThreadPool();                                                               // 析构函数
         template <typename Func, typename... Args>
         auto submit(Func &&f, Args &&...args) -> std::future<decltype(f(args...))>; // 提交任务,实现对线程任务的异步提交
+        template <typename Func, typename... Args>
+        void post(Func &&f, Args &&...args);                                           // 提交任务,不创建future,任务的异常交给异常处理函数
+        template <typename Func>
+        void execute(Func &&f);                                                        // 提交无参任务,等价于post(f)
+        void set_exception_handler(std::function<void(std::exception_ptr)> handler);  // 设置异常处理函数
+        class blocking_section // 阻塞区:任务在其中执行阻塞操作(I/O、等待锁等)时,线程池临时创建补偿线程保持并行度,离开后补偿线程退出
+        {
+        public:
+            explicit blocking_section(ThreadPool &pool);
+            ~blocking_section();
+            blocking_section(const blocking_section &) = delete;
+            blocking_section &operator=(const blocking_section &) = delete;
+        private:
+            ThreadPool *pool; // 当前线程不是该线程池的工作线程时为空,此时阻塞区不起作用
+        };
+        template <typename Func, typename... Args>
+        auto async(Func &&f, Args &&...args) -> pool_future<decltype(f(args...))>;    // 提交任务,返回的pool_future在工作线程上等待时会执行其他任务,定义在poolFuture.h中
+        template <typename Func, typename... Args>
+        auto submit_blocking(Func &&f, Args &&...args) -> std::future<decltype(f(args...))>; // 提交会阻塞的任务,任务在阻塞区中执行
+        void set_max_compensation_count(std::size_t count);                           // 设置补偿线程数量上限,默认等于初始线程数量
+        void prewarm();                                                                // 并行启动尚未启动的工作线程,并让每个工作线程预先触及栈、slab缓存与内存池
+        static std::pmr::memory_resource *current_arena();                            // 获取当前任务可用的内存池,每个任务结束后整体释放;不在工作线程上时返回默认内存资源
+        void set_arena(std::size_t size, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource()); // 设置内存池初始缓冲区大小与上游内存资源,工作线程在下一次使用时生效
+        Reactor &get_reactor();                                                        // 获取线程池的反应器,首次调用时创建反应器线程,I/O就绪回调作为任务在工作线程中执行
+        template <typename Func, typename... Args>
+        auto submit_to(std::size_t worker_index, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>; // 提交任务到指定工作线程的本地队列,下标对线程数量取模
+        template <typename Key, typename Func, typename... Args>
+        auto submit_affine(const Key &key, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>;       // 按键的哈希值选择工作线程,相同键的任务在同一个工作线程上执行
+        void set_steal_delay(std::chrono::nanoseconds delay);                         // 设置本地任务允许被窃取前的等待时间
+        template <typename Func, typename... Args>
+        auto submit_deadline(std::chrono::steady_clock::time_point deadline, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>; // 提交带截止时间的任务,截止时间早的任务先执行
+        template <typename Func, typename... Args>
+        void post_deadline(std::chrono::steady_clock::time_point deadline, Func &&f, Args &&...args);  // 提交带截止时间的任务,不创建future
+        void set_drop_expired(bool drop);                                            // 设置是否丢弃开始执行时已过截止时间的任务
+        std::size_t get_expired_task_count();                                        // 获取因过期被丢弃的任务数量
+        void set_admission_control(std::chrono::steady_clock::duration target, std::chrono::steady_clock::duration interval = std::chrono::milliseconds(100), bool shed = false); // 开启基于排队时间的准入控制,target为0时关闭
+        bool is_overloaded();                                                          // 当前是否因排队时间过长而拒绝新任务
+        std::size_t get_shed_task_count();                                             // 获取因过载被丢弃的排队任务数量
+        static constexpr std::size_t max_task_classes = 64;                          // 任务类别数量上限(包括默认类别)
+        struct task_class_stats                                                      // 任务类别的统计信息
+        {
+            std::size_t weight;         // 权重
+            std::size_t max_task_count; // 队列中任务的最大数量,0表示不限制
+            std::size_t queued;         // 当前排队的任务数量
+            std::size_t submitted;      // 累计加入队列的任务数量
+            std::size_t executed;       // 累计被工作线程取出的任务数量
+            std::size_t rejected;       // 累计因队列已满被拒绝的任务数量
+        };
+        std::size_t add_task_class(std::size_t weight, std::size_t max_task_count = 0); // 创建任务类别,返回类别编号
+        void set_task_class(std::size_t class_id, std::size_t weight, std::size_t max_task_count); // 修改任务类别的权重与队列上限,类别0的上限即线程池的max_task_count
+        task_class_stats get_task_class_stats(std::size_t class_id);                // 获取任务类别的统计信息
+        template <typename Func, typename... Args>
+        auto submit_class(std::size_t class_id, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>; // 提交任务到指定类别
+        template <typename Func, typename... Args>
+        void post_class(std::size_t class_id, Func &&f, Args &&...args);               // 提交任务到指定类别,不创建future
         void pause();                                                                  // 暂停线程池
         void resume();                                                                 // 恢复线程池
         void shutdown();                                                               // 立刻关闭线程池
         void shutdown_wait();                                                          // 等待任务执行完毕关闭线程池
+        std::vector<pooled_task> shutdown_for(std::chrono::steady_clock::duration timeout);        // 最多等待timeout后关闭线程池,返回未执行的任务
+        std::vector<pooled_task> shutdown_until(std::chrono::steady_clock::time_point deadline);   // 最多等待到deadline后关闭线程池,返回未执行的任务
         void terminate();                                                              // 终止线程池
+        bool terminate_for(std::chrono::steady_clock::duration timeout);               // 终止线程池并最多等待timeout让工作线程退出,全部退出返回true,超时未退出的线程在析构时回收
+        std::chrono::steady_clock::duration get_teardown_time();                       // 获取最近一次terminate_for等待工作线程退出所用的时间
         void wait();                                                                   // 等待所有任务执行完毕
-        void add_thread(std::size_t count);                                            // 增加线程
+        void add_thread(std::size_t count);                                            // 增加线程,延迟启动模式下新增的线程同样在任务到来时才启动
         void remove_thread(std::size_t count);                                         // 删除线程
         void set_max_task_count(std::size_t count);
         std::size_t get_task_count();   // 获取任务数量
         std::size_t get_thread_count(); // 获取线程数量
+        std::size_t get_configured_thread_count(); // 获取已启动与延迟启动模式下尚未启动的线程数量之和,即线程池配置的线程数量
     };
     inline void ThreadPool::set_max_task_count(std::size_t count_to_set)
     { // 设置任务队列中任务的最大数量；如果设置后的最大数量小于当前任务数量，则会拒绝新提交的任务，直到任务数量小于等于最大数量
@@ -90,41 +285,160 @@ namespace my_thread_poll
     sumbit函数实现线程池中任务的提交，它的工作流程如下:
     1.首先查看当前线程池的状态，如果不是RUNNING状态,抛出异常
     2.查看当前的任务队列是否已满，如果已满，则抛出异常
-    3.将任务转换为std::packaged_task对象，并将其包装为std::function对象，
-    以便在线程池中执行，这里使用了std::forward将参数传递给任务函数实现完美
-    转发,通过std::function对象将任务函数包装为std::function<void()>类型,
-    以便在线程池中通过在工作线程中可以用统一的格式（直接用 () 进行调用）对任
-    何形式的任务进行调用执行
-    4.将std::packaged_task对象添加到任务队列中，并返回一个std::future对象,该对象可以用于获取任务函数的返回值
+    3.(由pooledTask.h中的package_task完成)创建std::promise对象,其共享状态通过slab_allocator从当前线程的缓存中分配,
+    然后将任务函数、参数(通过std::forward完美转发后按值捕获)与promise一起包装为pooled_task对象,
+    pooled_task的控制块同样来自slab_allocator,以便在工作线程中可以用统一的格式（直接用 () 进行调用）对任
+    何形式的任务进行调用执行,任务的返回值或异常写入promise
+    4.将pooled_task对象添加到任务队列中，并返回一个std::future对象,该对象可以用于获取任务函数的返回值
+    稳态下整个提交过程不访问全局堆:控制块与共享状态在工作线程上释放时会归还到提交线程的缓存中
     */
     template <typename Func, typename... Args>
     auto ThreadPool::submit(Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
     {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock();
+        auto [task, res] = package_task(std::forward<Func>(f), std::forward<Args>(args)...);
+        push_task(std::move(task), true);
+        return std::move(res);
+    }
+
+    /*
+    post函数用于提交不关心返回值的任务,与submit相比省去了promise/future的创建:
+    任务函数与参数直接包装为pooled_task放入任务队列,任务的返回值被丢弃,
+    任务抛出的异常由工作线程捕获后交给set_exception_handler设置的异常处理函数
+    */
+    template <typename Func, typename... Args>
+    void ThreadPool::post(Func &&f, Args &&...args)
+    {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock();
+        if constexpr (sizeof...(Args) == 0)
+        {
+            push_task(pooled_task(std::forward<Func>(f)));
+        }
+        else
+        {
+            push_task(pooled_task([func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable
+            {
+                func(bound_args...);
+            }));
+        }
+    }
+
+    template <typename Func>
+    void ThreadPool::execute(Func &&f)
+    {
+        post(std::forward<Func>(f));
+    }
+
+    /*
+    submit_to与submit_affine将任务放入某个工作线程的本地队列,使访问同一份数据的任务在同一个工作线程上执行,提高缓存命中率:
+    1.目标工作线程总是优先执行自己本地队列中的任务
+    2.其他工作线程只有在任务等待超过steal_delay之后才能窃取,避免目标线程繁忙时任务无限等待
+    3.工作线程被移除时,其本地队列中剩余的任务转移到共享的任务队列中
+    */
+    template <typename Func, typename... Args>
+    auto ThreadPool::submit_to(std::size_t worker_index, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+    {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock(0, false);
+        auto [task, res] = package_task(std::forward<Func>(f), std::forward<Args>(args)...);
+        push_local_task(worker_index, std::move(task));
+        return std::move(res);
+    }
+
+    /*
+    截止时间优先(EDF)调度:
+    1.带截止时间的任务按提交线程id的哈希值放入某个截止时间分片,每个分片是按截止时间排序的小顶堆,不同生产者不竞争同一把锁
+    2.工作线程读取各个分片缓存的堆顶截止时间,只锁住截止时间最早的分片取出任务,因此总是执行截止时间最早的任务
+    3.带截止时间的任务优先于普通任务执行,工作线程本地队列中的任务除外
+    4.开启过期丢弃后,开始执行时已过截止时间的任务不再执行:submit_deadline返回的future抛出deadline_expired_error,post_deadline的任务直接丢弃
+    */
+    template <typename Func, typename... Args>
+    auto ThreadPool::submit_deadline(std::chrono::steady_clock::time_point deadline, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+    {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock(0, false);
+        using return_type = decltype(f(args...));
+        auto [task, res] = package_task([this, deadline, func = std::forward<Func>(f)](auto &...bound_args) mutable -> return_type
+        {
+            if (drop_if_expired(deadline))
+                throw deadline_expired_error();
+            return func(bound_args...);
+        }, std::forward<Args>(args)...);
+        push_deadline_task(deadline, std::move(task));
+        return std::move(res);
+    }
+
+    template <typename Func, typename... Args>
+    void ThreadPool::post_deadline(std::chrono::steady_clock::time_point deadline, Func &&f, Args &&...args)
+    {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock(0, false);
+        push_deadline_task(deadline, pooled_task([this, deadline, func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable
+        {
+            if (!drop_if_expired(deadline))
+                func(bound_args...);
+        }));
+    }
+
+    /*
+    多个租户共享线程池时,为每个租户创建一个任务类别,各类别拥有独立的队列上限,
+    工作线程在各个类别(包括默认类别)之间按赤字轮询(DRR)取任务:每轮依次访问各个类别,
+    每个非空类别最多连续取出weight个任务,因此各类别获得的执行机会与权重成正比,
+    一个租户填满自己的队列也不会影响其他租户的提交与执行
+    只有默认类别时工作线程直接扫描分片,不经过轮询调度
+    */
+    template <typename Func, typename... Args>
+    auto ThreadPool::submit_class(std::size_t class_id, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+    {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
+        std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+        check_submit_with_status_lock(class_id);
+        auto [task, res] = package_task(std::forward<Func>(f), std::forward<Args>(args)...);
+        push_class_task(class_id, std::move(task), true);
+        return std::move(res);
+    }
+
+    template <typename Func, typename... Args>
+    void ThreadPool::post_class(std::size_t class_id, Func &&f, Args &&...args)
+    {
+        THREAD_POOL_PROFILE_SCOPE(SUBMIT);
         std::shared_lock<std::shared_mutex> status_lock(status_mutex);
-        switch (status.load())
-        {
-            case status_t::TERMINATED:
-            throw std::runtime_error("ThreadPool is terminated");
-            case status_t::TERMINATING:
-            throw std::runtime_error("ThreadPool is terminating");
-            case status_t::PAUSED:
-            throw std::runtime_error("ThreadPool is paused");
-            case status_t::SHUTDOWN:
-            throw std::runtime_error("ThreadPool is shutdown");
-            case status_t::RUNNING:
-            break;
+        check_submit_with_status_lock(class_id);
+        if constexpr (sizeof...(Args) == 0)
+        {
+            push_class_task(class_id, pooled_task(std::forward<Func>(f)));
+        }
+        else
+        {
+            push_class_task(class_id, pooled_task([func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable
+            {
+                func(bound_args...);
+            }));
         }
-        if(max_task_count > 0&&max_task_count.load()==get_task_count())
-            throw std::runtime_error("ThreadPool is full");
-        using return_type=decltype(f(args...));
-        auto task=std::make_shared<std::packaged_task<return_type()>>(std::bind(std::forward<Func>(f), std::forward<Args>(args)...));
-        std::unique_lock<std::shared_mutex> lock2(task_queue_mutex);
-        task_queue.emplace([task](){ (*task)(); }); 
-        lock2.unlock();
-        status_lock.unlock();
-        task_queue_cv.notify_one();  //唤醒一个线程来执行当前任务
-        std::future<return_type> res=task->get_future();
-        return res;
+    }
+
+    template <typename Func, typename... Args>
+    auto ThreadPool::submit_blocking(Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+    {
+        using return_type = decltype(f(args...));
+        return submit([this, func = std::forward<Func>(f), ... bound_args = std::forward<Args>(args)]() mutable -> return_type
+        {
+            blocking_section section(*this);
+            return func(bound_args...);
+        });
+    }
+
+    template <typename Key, typename Func, typename... Args>
+    auto ThreadPool::submit_affine(const Key &key, Func &&f, Args &&...args) -> std::future<decltype(f(args...))>
+    {
+        return submit_to(std::hash<Key>{}(key), std::forward<Func>(f), std::forward<Args>(args)...);
     }
 
     class ThreadPool::worker_thread
@@ -141,6 +455,23 @@ namespace my_thread_poll
             std::atomic<status_t> status; //线程状态
             std::shared_mutex status_mutex; //线程状态互斥锁
             std::binary_semaphore sem; //信号量,要来控制线程的阻塞和唤醒
+            std::size_t home_shard; //所属的任务队列分片,取任务时优先从该分片中取
+            struct local_task_t
+            {
+                pooled_task task;                                   //任务
+                std::chrono::steady_clock::time_point enqueue_time; //加入本地队列的时间,用于判断是否允许窃取
+            };
+            std::mutex local_mutex; //本地队列的互斥锁
+            std::atomic<std::size_t> local_size{0}; //本地队列中的任务数量
+            std::queue<local_task_t, std::deque<local_task_t, slab_allocator<local_task_t>>> local_queue; //本地队列,存放指定由该线程执行的任务
+            std::atomic<bool> idle{false}; //是否阻塞在task_queue_cv上,向本地队列添加任务时据此决定是否唤醒
+            std::unique_ptr<std::byte[]> arena_buffer; //内存池的初始缓冲区,只由该线程访问
+            std::size_t arena_buffer_size = 0; //初始缓冲区的大小
+            std::pmr::memory_resource *arena_upstream = nullptr; //创建内存池时使用的上游内存资源
+            std::optional<std::pmr::monotonic_buffer_resource> arena; //内存池,第一次使用时创建
+            bool arena_used = false; //当前任务是否使用了内存池,使用过才需要在任务结束后释放
+            bool warmed = false; //是否已经预热,只由该线程访问
+            std::atomic<bool> exited{false}; //线程函数是否已经返回,为true时join不会阻塞
             std::thread thread; //工作线程
             //禁用拷贝构造与移动构造以及相关复赋值
             worker_thread(const worker_thread &) = delete;
@@ -151,7 +482,12 @@ namespace my_thread_poll
             void resume_with_status_lock();
             status_t terminate_with_status_lock();
             void pause_with_status_lock();
-            
+            bool pop_local(pooled_task &task, std::chrono::steady_clock::time_point enqueued_before); //从本地队列取出一个在enqueued_before之前加入的任务
+            std::pmr::memory_resource *get_arena(); //获取内存池,配置变化时重新创建
+            void reset_arena(); //任务结束后释放内存池中的全部分配
+            void warm_up(); //预先触及栈、slab缓存与内存池,避免第一个任务承担缺页与初始化的开销
+            friend class ThreadPool;
+
         public:
             worker_thread(ThreadPool *pool);
             ~worker_thread();
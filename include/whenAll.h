@@ -0,0 +1,223 @@
+/**
+ * @file whenAll.h
+ * @author fengxu (2112873995@qq.com)
+ * @brief pool_future的组合器when_all/when_any,通过共享状态上的回调与原子计数完成,不占用任何等待线程
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef WHENALL_H
+#define WHENALL_H
+
+#include <tuple>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include "poolFuture.h"
+
+namespace my_thread_poll
+{
+    template <typename Sequence>
+    struct when_any_result // when_any的结果
+    {
+        std::size_t index;  // 第一个就绪的future在输入中的下标,输入为空时为std::size_t(-1)
+        Sequence futures;   // 全部输入的future
+    };
+
+    struct pool_future_access // 组合器访问pool_future内部状态的入口
+    {
+        template <typename T>
+        static pool_state<T> *state(const pool_future<T> &future) noexcept { return future.state; }
+        template <typename T>
+        static ThreadPool *pool(const pool_future<T> &future) noexcept { return future.pool; }
+    };
+
+    /*
+    pool_combine_state是组合器的共享状态,工作方式如下:
+    1.持有全部输入的future,并在每个输入的共享状态上登记一个回调节点,引用计数为1(结果future) + 输入数量(每个回调节点一个)
+    2.每个输入就绪时,写入其结果的线程执行对应节点的on_ready,然后释放该节点的引用
+    3.when_all在原子计数归零时发布结果,when_any在第一个输入就绪时发布结果;发布结果时将输入的future移动到结果中
+    整个过程中没有线程阻塞等待,组合器的结果本身也是pool_future,可以继续参与组合
+    */
+    template <typename Result, typename Sequence>
+    class pool_combine_state : public pool_state<Result>
+    {
+    public:
+        static pool_future<Result> start(Sequence &&futures, ThreadPool *pool, bool any)
+        {
+            std::vector<pool_state_base *> inputs;
+            collect(futures, inputs);
+            slab_allocator<pool_combine_state> alloc;
+            pool_combine_state *p = alloc.allocate(1);
+            try
+            {
+                ::new (static_cast<void *>(p)) pool_combine_state(std::move(futures), inputs.size(), any);
+            }
+            catch (...)
+            {
+                alloc.deallocate(p, 1);
+                throw;
+            }
+            pool_future<Result> res(pool, p);
+            if (inputs.empty())
+            {
+                p->complete(std::size_t(-1));
+            }
+            // 通过事先取得的指针登记回调:回调可能立即执行并把futures移动到结果中
+            for (std::size_t i = 0; i < inputs.size(); ++i)
+            {
+                inputs[i]->then(&p->nodes[i]);
+            }
+            return res;
+        }
+
+    private:
+        struct node_t final : pool_continuation // 登记在一个输入上的回调节点
+        {
+            pool_combine_state *owner = nullptr;
+            std::size_t index = 0;
+            void run() noexcept override
+            {
+                pool_combine_state *state = owner;
+                state->on_ready(index);
+                state->release();
+            }
+        };
+
+        Sequence futures;                                        // 全部输入的future,发布结果前由共享状态持有
+        std::vector<node_t, slab_allocator<node_t>> nodes;       // 每个输入一个回调节点
+        std::atomic<std::size_t> pending;                        // when_all中尚未就绪的输入数量
+        std::atomic<bool> completed{false};                      // 结果是否已经发布
+        const bool any;                                          // 是否为when_any
+
+        pool_combine_state(Sequence &&futures, std::size_t count, bool any)
+            : futures(std::move(futures)), nodes(count), pending(count), any(any)
+        {
+            this->refs.store(static_cast<std::uint32_t>(count + 1), std::memory_order_relaxed);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                nodes[i].owner = this;
+                nodes[i].index = i;
+            }
+        }
+
+        void on_ready(std::size_t index) noexcept
+        {
+            if (any || pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                complete(index);
+            }
+        }
+
+        void complete(std::size_t index) noexcept
+        {
+            if (completed.exchange(true, std::memory_order_acq_rel))
+            {
+                return;
+            }
+            try
+            {
+                if constexpr (std::is_same_v<Result, Sequence>)
+                    this->set_value(std::move(futures));
+                else
+                    this->set_value(Result{index, std::move(futures)});
+            }
+            catch (...)
+            {
+                this->set_exception(std::current_exception());
+            }
+        }
+
+        void destroy_state() noexcept override
+        {
+            slab_allocator<pool_combine_state> alloc;
+            this->~pool_combine_state();
+            alloc.deallocate(this, 1);
+        }
+
+        template <typename T>
+        static void collect(std::vector<pool_future<T>> &futures, std::vector<pool_state_base *> &inputs)
+        {
+            for (auto &future : futures)
+            {
+                inputs.push_back(checked_state(future));
+            }
+        }
+
+        template <typename... Ts>
+        static void collect(std::tuple<pool_future<Ts>...> &futures, std::vector<pool_state_base *> &inputs)
+        {
+            std::apply([&inputs](auto &...future) { (inputs.push_back(checked_state(future)), ...); }, futures);
+        }
+
+        template <typename T>
+        static pool_state_base *checked_state(const pool_future<T> &future)
+        {
+            if (!future.valid())
+            {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            return pool_future_access::state(future);
+        }
+    };
+
+    template <typename T>
+    ThreadPool *first_pool(const std::vector<pool_future<T>> &futures) // 结果future在工作线程上等待时帮助执行的线程池
+    {
+        return futures.empty() ? nullptr : pool_future_access::pool(futures.front());
+    }
+
+    template <typename... Ts>
+    ThreadPool *first_pool(const std::tuple<pool_future<Ts>...> &futures)
+    {
+        if constexpr (sizeof...(Ts) == 0)
+            return nullptr;
+        else
+            return pool_future_access::pool(std::get<0>(futures));
+    }
+
+    template <typename InputIt>
+    auto when_all(InputIt first, InputIt last) // 全部输入就绪后就绪,结果为全部输入future组成的vector
+        -> pool_future<std::vector<typename std::iterator_traits<InputIt>::value_type>>
+    {
+        using sequence_t = std::vector<typename std::iterator_traits<InputIt>::value_type>;
+        sequence_t futures(std::make_move_iterator(first), std::make_move_iterator(last));
+        ThreadPool *pool = first_pool(futures);
+        return pool_combine_state<sequence_t, sequence_t>::start(std::move(futures), pool, false);
+    }
+
+    template <typename... Ts>
+    auto when_all(pool_future<Ts>... futures) -> pool_future<std::tuple<pool_future<Ts>...>> // 全部输入就绪后就绪,结果为输入future组成的tuple
+    {
+        using sequence_t = std::tuple<pool_future<Ts>...>;
+        sequence_t sequence(std::move(futures)...);
+        ThreadPool *pool = first_pool(sequence);
+        return pool_combine_state<sequence_t, sequence_t>::start(std::move(sequence), pool, false);
+    }
+
+    template <typename InputIt>
+    auto when_any(InputIt first, InputIt last) // 任意一个输入就绪后就绪,结果中记录该输入的下标
+        -> pool_future<when_any_result<std::vector<typename std::iterator_traits<InputIt>::value_type>>>
+    {
+        using sequence_t = std::vector<typename std::iterator_traits<InputIt>::value_type>;
+        sequence_t futures(std::make_move_iterator(first), std::make_move_iterator(last));
+        ThreadPool *pool = first_pool(futures);
+        return pool_combine_state<when_any_result<sequence_t>, sequence_t>::start(std::move(futures), pool, true);
+    }
+
+    template <typename... Ts>
+    auto when_any(pool_future<Ts>... futures) -> pool_future<when_any_result<std::tuple<pool_future<Ts>...>>>
+    {
+        using sequence_t = std::tuple<pool_future<Ts>...>;
+        sequence_t sequence(std::move(futures)...);
+        ThreadPool *pool = first_pool(sequence);
+        return pool_combine_state<when_any_result<sequence_t>, sequence_t>::start(std::move(sequence), pool, true);
+    }
+};
+
+#endif // WHENALL_H
@@ -0,0 +1,189 @@
+#include "../../include/configWatcher.h"
+#include "../../include/ini.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+namespace my_thread_poll
+{
+    static std::runtime_error config_watcher_error(const char *where) // 根据errno构造异常
+    {
+        return std::runtime_error(std::string("[config_watcher::") + where + "][error]: " + std::strerror(errno));
+    }
+
+    static bool parse_count(const std::string &text, std::size_t &count) // 整个文本必须是非负整数
+    {
+        const char *first = text.data(), *last = text.data() + text.size();
+        auto res = std::from_chars(first, last, count);
+        return !text.empty() && res.ec == std::errc() && res.ptr == last;
+    }
+
+    ConfigWatcher::ConfigWatcher(ThreadPool &pool, const std::string &filename, std::chrono::milliseconds debounce, std::size_t max_thread_count)
+        : pool(pool), filename(filename), debounce(debounce), max_thread_count(max_thread_count)
+    {
+        std::size_t slash = filename.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : filename.substr(0, slash));
+        watched_name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+        inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0)
+            throw config_watcher_error("inotify_init1");
+        // 监听目录而不是文件:编辑器保存时常以新文件重命名覆盖原文件,直接监听文件会在第一次保存后失效
+        if (::inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            std::runtime_error e = config_watcher_error("inotify_add_watch");
+            ::close(inotify_fd);
+            throw e;
+        }
+        event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd < 0)
+        {
+            std::runtime_error e = config_watcher_error("eventfd");
+            ::close(inotify_fd);
+            throw e;
+        }
+        thread = std::thread(&ConfigWatcher::run, this);
+    }
+
+    ConfigWatcher::~ConfigWatcher()
+    {
+        stop();
+        ::close(inotify_fd);
+        ::close(event_fd);
+    }
+
+    void ConfigWatcher::stop()
+    {
+        if (!stopping.exchange(true))
+        {
+            std::uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = ::write(event_fd, &one, sizeof(one));
+        }
+        if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+        {
+            thread.join();
+        }
+    }
+
+    void ConfigWatcher::run()
+    {
+        bool pending = false; // 是否有尚未应用的修改
+        std::chrono::steady_clock::time_point deadline;
+        pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {event_fd, POLLIN, 0}};
+        while (!stopping.load())
+        {
+            int timeout = -1;
+            if (pending)
+            {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining.count(), 0));
+            }
+            int n = ::poll(fds, 2, timeout);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                error_count.fetch_add(1);
+                std::cerr << config_watcher_error("poll").what() << std::endl;
+                return;
+            }
+            if (fds[1].revents)
+            {
+                return;
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                alignas(inotify_event) char buffer[4096];
+                ssize_t len;
+                while ((len = ::read(inotify_fd, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char *p = buffer; p < buffer + len;)
+                    {
+                        auto *event = reinterpret_cast<inotify_event *>(p);
+                        if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && watched_name == event->name))
+                        {
+                            pending = true;
+                            deadline = std::chrono::steady_clock::now() + debounce; // 每次修改都重新计时
+                        }
+                        p += sizeof(inotify_event) + event->len;
+                    }
+                }
+            }
+            if (pending && std::chrono::steady_clock::now() >= deadline)
+            {
+                pending = false;
+                reload();
+            }
+        }
+    }
+
+    bool ConfigWatcher::reload()
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        utils::IniFile ini;
+        if (!ini.load(filename))
+            return fail("cannot load " + filename);
+        if (!ini.has("thread_pool"))
+            return fail("missing [thread_pool] section");
+        std::optional<std::size_t> thread_count, max_task_count;
+        if (const utils::Value *value = ini.find("thread_pool", "inital_thread_count"))
+        {
+            std::size_t count;
+            if (!parse_count(*value, count) || count == 0 || count > max_thread_count)
+                return fail("invalid inital_thread_count: " + std::string(*value));
+            thread_count = count;
+        }
+        if (const utils::Value *value = ini.find("thread_pool", "max_task_count"))
+        {
+            std::size_t count;
+            if (!parse_count(*value, count))
+                return fail("invalid max_task_count: " + std::string(*value));
+            max_task_count = count;
+        }
+        try
+        {
+            if (max_task_count)
+            {
+                pool.set_max_task_count(*max_task_count);
+            }
+            if (thread_count)
+            {
+                //延迟启动模式下尚未启动的线程同样计入,remove_thread也会先减少这部分线程
+                std::size_t current = pool.get_configured_thread_count();
+                if (*thread_count > current)
+                    pool.add_thread(*thread_count - current);
+                else if (*thread_count < current)
+                    pool.remove_thread(current - *thread_count);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            return fail(e.what());
+        }
+        reload_count.fetch_add(1);
+        return true;
+    }
+
+    bool ConfigWatcher::fail(const std::string &message)
+    {
+        error_count.fetch_add(1);
+        std::cerr << "[config_watcher::reload][error]: " << message << std::endl;
+        return false;
+    }
+
+    std::size_t ConfigWatcher::get_reload_count()
+    {
+        return reload_count.load();
+    }
+
+    std::size_t ConfigWatcher::get_error_count()
+    {
+        return error_count.load();
+    }
+};
@@ -0,0 +1,14 @@
+#include "../../include/poolFuture.h"
+
+namespace my_thread_poll
+{
+    bool pool_future_base::on_worker_thread() const
+    {
+        return pool != nullptr && pool->is_current_worker();
+    }
+
+    bool pool_future_base::help() const
+    {
+        return pool->run_pending_task();
+    }
+};
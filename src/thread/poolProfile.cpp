@@ -0,0 +1,127 @@
+#include "../../include/poolProfile.h"
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+namespace my_thread_poll
+{
+    namespace profile
+    {
+        namespace
+        {
+            struct registry_t // 所有线程的计数,以及已经退出的线程的总和
+            {
+                std::mutex mutex;
+                std::vector<thread_counters *> threads;
+                std::array<std::uint64_t, PHASE_COUNT> retired_count{};
+                std::array<std::uint64_t, PHASE_COUNT> retired_ticks{};
+                std::uint64_t base_ticks = now(); // 用于将时间戳换算为纳秒的起点
+                std::chrono::steady_clock::time_point base_time = std::chrono::steady_clock::now();
+            };
+
+            registry_t &registry()
+            {
+                static registry_t instance;
+                return instance;
+            }
+
+            double nanoseconds_per_tick(registry_t &reg) // 时间戳计数器的频率由起点以来经过的周期数与时间估算
+            {
+#if defined(THREAD_POOL_PROFILE) && (defined(__x86_64__) || defined(__i386__))
+                std::uint64_t ticks = now() - reg.base_ticks;
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - reg.base_time).count();
+                return ticks > 0 ? static_cast<double>(elapsed) / static_cast<double>(ticks) : 1.0;
+#else
+                return 1.0;
+#endif
+            }
+        };
+
+        thread_counters::thread_counters()
+        {
+            registry_t &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.threads.push_back(this);
+        }
+
+        thread_counters::~thread_counters()
+        {
+            registry_t &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (std::size_t i = 0; i < PHASE_COUNT; ++i)
+            {
+                reg.retired_count[i] += count[i].load(std::memory_order_relaxed);
+                reg.retired_ticks[i] += ticks[i].load(std::memory_order_relaxed);
+            }
+            reg.threads.erase(std::remove(reg.threads.begin(), reg.threads.end(), this), reg.threads.end());
+        }
+
+        report_t snapshot()
+        {
+            registry_t &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            double scale = nanoseconds_per_tick(reg);
+            report_t res;
+            for (std::size_t i = 0; i < PHASE_COUNT; ++i)
+            {
+                std::uint64_t count = reg.retired_count[i];
+                std::uint64_t ticks = reg.retired_ticks[i];
+                for (thread_counters *counters : reg.threads)
+                {
+                    count += counters->count[i].load(std::memory_order_relaxed);
+                    ticks += counters->ticks[i].load(std::memory_order_relaxed);
+                }
+                res[i].count = count;
+                res[i].nanoseconds = static_cast<std::uint64_t>(static_cast<double>(ticks) * scale);
+            }
+            return res;
+        }
+
+        void reset() // 与正在记录的线程并发调用时,个别记录可能丢失
+        {
+            registry_t &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.retired_count.fill(0);
+            reg.retired_ticks.fill(0);
+            for (thread_counters *counters : reg.threads)
+            {
+                for (std::size_t i = 0; i < PHASE_COUNT; ++i)
+                {
+                    counters->count[i].store(0, std::memory_order_relaxed);
+                    counters->ticks[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        const char *phase_name(phase_t phase)
+        {
+            static const char *names[PHASE_COUNT] = {"submit", "enqueue", "wakeup", "dequeue", "idle", "execute"};
+            return phase < PHASE_COUNT ? names[phase] : "unknown";
+        }
+
+        void report(std::ostream &out)
+        {
+#ifndef THREAD_POOL_PROFILE
+            out << "[thread_pool::profile]: profiling is disabled, rebuild with THREAD_POOL_PROFILE" << std::endl;
+#endif
+            report_t stats = snapshot();
+            for (std::size_t i = 0; i < PHASE_COUNT; ++i)
+            {
+                const phase_stats &s = stats[i];
+                out << "[thread_pool::profile]: " << phase_name(static_cast<phase_t>(i))
+                    << " count=" << s.count
+                    << " total_ns=" << s.nanoseconds
+                    << " avg_ns=" << (s.count > 0 ? s.nanoseconds / s.count : 0) << std::endl;
+            }
+            // 调度开销 = 提交(已包含入队与唤醒) + 取任务,不包括阻塞等待与用户代码
+            std::uint64_t tasks = stats[EXECUTE].count;
+            if (tasks > 0)
+            {
+                std::uint64_t overhead = stats[SUBMIT].nanoseconds + stats[DEQUEUE].nanoseconds;
+                out << "[thread_pool::profile]: overhead_per_task_ns=" << overhead / tasks
+                    << " user_per_task_ns=" << stats[EXECUTE].nanoseconds / tasks << std::endl;
+            }
+        }
+    };
+};
@@ -0,0 +1,220 @@
+#include "../../include/reactor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+namespace my_thread_poll
+{
+    static std::runtime_error reactor_error(const char *where) // 根据errno构造异常
+    {
+        return std::runtime_error(std::string("[reactor::") + where + "][error]: " + std::strerror(errno));
+    }
+
+    Reactor::state_t::~state_t()
+    {
+        if (epoll_fd >= 0)
+            ::close(epoll_fd);
+        if (event_fd >= 0)
+            ::close(event_fd);
+    }
+
+    Reactor::Reactor(ThreadPool &pool) : state(std::make_shared<state_t>())
+    {
+        state->pool = &pool;
+        state->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (state->epoll_fd < 0)
+            throw reactor_error("epoll_create1");
+        state->event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (state->event_fd < 0)
+            throw reactor_error("eventfd");
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = state->event_fd;
+        if (::epoll_ctl(state->epoll_fd, EPOLL_CTL_ADD, state->event_fd, &ev) < 0)
+            throw reactor_error("epoll_ctl");
+        thread = std::thread(&Reactor::run, this);
+    }
+
+    Reactor::~Reactor()
+    {
+        stop();
+    }
+
+    void Reactor::add(int fd, std::uint32_t events, callback_t callback)
+    {
+        auto handler = std::make_shared<handler_t>();
+        handler->callback = std::move(callback);
+        handler->events = events;
+        add_handler(fd, std::move(handler));
+    }
+
+    void Reactor::add_handler(int fd, std::shared_ptr<handler_t> handler)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->handlers.count(fd))
+            throw std::runtime_error("[reactor::add][error]: fd is already registered");
+        epoll_event ev{};
+        ev.events = handler->events | EPOLLONESHOT;
+        ev.data.fd = fd;
+        if (::epoll_ctl(state->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+            throw reactor_error("add");
+        state->handlers.emplace(fd, std::move(handler));
+    }
+
+    void Reactor::modify(int fd, std::uint32_t events)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto it = state->handlers.find(fd);
+        if (it == state->handlers.end())
+            throw std::runtime_error("[reactor::modify][error]: fd is not registered");
+        it->second->events = events;
+        epoll_event ev{};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.fd = fd;
+        // 回调正在执行时也会立即重新注册,新的就绪事件可能在回调结束前被分发
+        if (::epoll_ctl(state->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0)
+            throw reactor_error("modify");
+    }
+
+    void Reactor::remove(int fd)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->handlers.erase(fd) == 0)
+            return;
+        ::epoll_ctl(state->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    int Reactor::add_timer(std::chrono::nanoseconds interval, callback_t callback, bool repeat)
+    {
+        int timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timer_fd < 0)
+            throw reactor_error("add_timer");
+        if (interval <= std::chrono::nanoseconds::zero()) // 超时时间为0会解除定时器,取最小值代替
+            interval = std::chrono::nanoseconds(1);
+        itimerspec spec{};
+        spec.it_value.tv_sec = interval.count() / 1000000000;
+        spec.it_value.tv_nsec = interval.count() % 1000000000;
+        if (repeat)
+            spec.it_interval = spec.it_value;
+        if (::timerfd_settime(timer_fd, 0, &spec, nullptr) < 0)
+        {
+            std::runtime_error e = reactor_error("add_timer");
+            ::close(timer_fd);
+            throw e;
+        }
+        try
+        {
+            auto handler = std::make_shared<handler_t>();
+            handler->callback = std::move(callback);
+            handler->events = EPOLLIN;
+            handler->is_timer = true;
+            add_handler(timer_fd, std::move(handler));
+        }
+        catch (...)
+        {
+            ::close(timer_fd);
+            throw;
+        }
+        return timer_fd;
+    }
+
+    void Reactor::remove_timer(int timer_fd)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto it = state->handlers.find(timer_fd);
+        if (it == state->handlers.end() || !it->second->is_timer)
+            return;
+        state->handlers.erase(it);
+        ::epoll_ctl(state->epoll_fd, EPOLL_CTL_DEL, timer_fd, nullptr);
+        ::close(timer_fd);
+    }
+
+    void Reactor::stop()
+    {
+        if (!state->stopping.exchange(true))
+        {
+            std::uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = ::write(state->event_fd, &one, sizeof(one));
+        }
+        if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+        {
+            thread.join();
+        }
+    }
+
+    /*
+    反应器线程的工作流程如下:
+    1.阻塞在epoll_wait上等待就绪事件
+    2.eventfd就绪表示需要停止,退出循环
+    3.其他文件描述符就绪时,将回调包装为任务提交到线程池;由于使用EPOLLONESHOT,
+    在回调执行完毕并重新注册之前,该文件描述符不会再次被分发
+    */
+    void Reactor::run()
+    {
+        constexpr int max_events = 64;
+        epoll_event events[max_events];
+        while (!state->stopping.load())
+        {
+            int n = ::epoll_wait(state->epoll_fd, events, max_events, -1);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                int fd = events[i].data.fd;
+                if (fd == state->event_fd)
+                {
+                    continue; // 由循环条件检查是否停止
+                }
+                std::uint32_t ready = events[i].events;
+                try
+                {
+                    state->pool->post([state = this->state, fd, ready]() { dispatch(state, fd, ready); });
+                }
+                catch (...) // 线程池不接收新任务时在反应器线程上执行
+                {
+                    dispatch(state, fd, ready);
+                }
+            }
+        }
+    }
+
+    void Reactor::dispatch(const std::shared_ptr<state_t> &state, int fd, std::uint32_t events)
+    {
+        std::shared_ptr<handler_t> handler;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto it = state->handlers.find(fd);
+            if (it == state->handlers.end()) // 已经取消注册
+                return;
+            handler = it->second;
+            if (handler->is_timer) // 持有锁读取,避免与remove_timer关闭timerfd交错
+            {
+                std::uint64_t expirations;
+                [[maybe_unused]] ssize_t n = ::read(fd, &expirations, sizeof(expirations));
+            }
+        }
+        try
+        {
+            handler->callback(fd, events);
+        }
+        catch (...)
+        {
+            state->pool->handle_exception(std::current_exception());
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto it = state->handlers.find(fd);
+        if (it == state->handlers.end() || it->second != handler) // 回调中取消注册,或文件描述符已被重新注册
+            return;
+        epoll_event ev{};
+        ev.events = handler->events | EPOLLONESHOT;
+        ev.data.fd = fd;
+        ::epoll_ctl(state->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    }
+};
@@ -0,0 +1,138 @@
+#include "../../include/slabAllocator.h"
+
+#include <bit>
+
+namespace my_thread_poll
+{
+    // 线程退出时释放所属线程对缓存持有的引用
+    struct slab_cache_holder
+    {
+        slab_cache *cache = nullptr;
+        ~slab_cache_holder()
+        {
+            if (cache)
+            {
+                slab_cache *last = cache;
+                cache = nullptr;
+                last->release();
+            }
+        }
+    };
+
+    static thread_local slab_cache_holder local_cache_holder;
+
+    slab_cache &slab_cache::local()
+    {
+        if (!local_cache_holder.cache)
+        {
+            local_cache_holder.cache = new slab_cache;
+        }
+        return *local_cache_holder.cache;
+    }
+
+    slab_cache::~slab_cache()
+    {
+        for (char *chunk : chunks)
+        {
+            ::operator delete(chunk);
+        }
+    }
+
+    std::size_t slab_cache::class_index(std::size_t size) noexcept
+    {
+        if (size <= min_block_size)
+            return 0;
+        return std::bit_width(size - 1) - std::bit_width(min_block_size - 1);
+    }
+
+    void *slab_cache::allocate(std::size_t size)
+    {
+        if (size > max_block_size) // 大对象直接使用全局堆
+        {
+            auto *header = static_cast<block_header *>(::operator new(sizeof(block_header) + size));
+            header->owner = nullptr;
+            header->size_class = 0;
+            return header + 1;
+        }
+        return local().allocate_block(class_index(size));
+    }
+
+    void *slab_cache::allocate_block(std::size_t index)
+    {
+        size_class_t &cls = classes[index];
+        free_block *block = cls.local_free;
+        if (!block) // 本地空闲链表为空时,一次性取回其他线程归还的块
+        {
+            block = cls.remote_free.exchange(nullptr, std::memory_order_acquire);
+        }
+        void *result;
+        if (block)
+        {
+            cls.local_free = block->next;
+            result = block;
+        }
+        else
+        {
+            std::size_t block_size = sizeof(block_header) + (min_block_size << index);
+            if (cls.bump == nullptr || static_cast<std::size_t>(cls.bump_end - cls.bump) < block_size)
+            {
+                char *chunk = static_cast<char *>(::operator new(chunk_size));
+                try
+                {
+                    chunks.push_back(chunk);
+                }
+                catch (...)
+                {
+                    ::operator delete(chunk);
+                    throw;
+                }
+                cls.bump = chunk;
+                cls.bump_end = chunk + chunk_size;
+            }
+            auto *header = reinterpret_cast<block_header *>(cls.bump);
+            header->owner = this;
+            header->size_class = index;
+            cls.bump += block_size;
+            result = header + 1;
+        }
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    void slab_cache::deallocate(void *p) noexcept
+    {
+        if (!p)
+            return;
+        auto *header = static_cast<block_header *>(p) - 1;
+        slab_cache *owner = header->owner;
+        if (!owner)
+        {
+            ::operator delete(header);
+            return;
+        }
+        size_class_t &cls = owner->classes[header->size_class];
+        auto *block = static_cast<free_block *>(p);
+        if (owner == local_cache_holder.cache) // 所属线程释放,直接放回本地空闲链表
+        {
+            block->next = cls.local_free;
+            cls.local_free = block;
+        }
+        else // 其他线程释放,压入所属缓存的远程空闲链表
+        {
+            free_block *head = cls.remote_free.load(std::memory_order_relaxed);
+            do
+            {
+                block->next = head;
+            } while (!cls.remote_free.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+        }
+        owner->release();
+    }
+
+    void slab_cache::release() noexcept
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+};
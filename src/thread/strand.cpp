@@ -0,0 +1,64 @@
+#include "../../include/strand.h"
+
+namespace my_thread_poll
+{
+    Strand::Strand(ThreadPool &pool) : state(std::make_shared<state_t>(&pool)) {}
+
+    void Strand::push(pooled_task &&task)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->queue.emplace(std::move(task));
+        if (state->scheduled) // 已有排空任务,它会按顺序执行新加入的任务
+        {
+            return;
+        }
+        try
+        {
+            // 持有锁提交排空任务:提交失败时队列中只有刚加入的任务,可以安全撤销
+            state->pool->post([state = this->state]() { drain(state); });
+        }
+        catch (...)
+        {
+            state->queue.pop();
+            throw;
+        }
+        state->scheduled = true;
+    }
+
+    void Strand::drain(const std::shared_ptr<state_t> &state)
+    {
+        while (true)
+        {
+            for (std::size_t i = 0; i < batch_size; ++i)
+            {
+                pooled_task task;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->queue.empty())
+                    {
+                        state->scheduled = false;
+                        return;
+                    }
+                    task = std::move(state->queue.front());
+                    state->queue.pop();
+                }
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    state->pool->handle_exception(std::current_exception());
+                }
+            }
+            try // 让出工作线程,由新的排空任务继续执行剩余任务
+            {
+                state->pool->post([state]() { drain(state); });
+                return;
+            }
+            catch (...) // 线程池不再接收新任务时在当前线程上继续执行
+            {
+            }
+        }
+    }
+};
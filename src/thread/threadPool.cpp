@@ -1,19 +1,58 @@
 #include "../../include/threadPool.h"
+#include "../../include/reactor.h"
+#include <iostream>
+#include <algorithm>
 
 namespace my_thread_poll
 {
-    ThreadPool::ThreadPool(std::size_t inital_thread_count, std::size_t max_task_count)
-        : max_task_count(max_task_count), status(status_t::RUNNING)
+    ThreadPool::ThreadPool(std::size_t inital_thread_count, std::size_t max_task_count, std::size_t shard_count, bool lazy_start)
+        : max_task_count(max_task_count), status(status_t::RUNNING),
+          shard_count(shard_count != 0 ? shard_count : std::max<std::size_t>(inital_thread_count, 1)),
+          task_shards(new task_shard[this->shard_count]),
+          deadline_shards(new deadline_shard[this->shard_count]),
+          task_classes(new task_class_t[max_task_classes]),
+          steal_delay(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::milliseconds(1)).count())
     {
+        max_compensation_count.store(inital_thread_count);
+        this->lazy_start = lazy_start;
+        if (lazy_start)
+        {
+            lazy_thread_count.store(inital_thread_count);
+            return;
+        }
+        std::unique_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
         for (int i = 0; i < inital_thread_count; ++i)
         {
             worker_lists.emplace_back(this);
         }
+        rebuild_worker_index();
     }
 
     ThreadPool::~ThreadPool()
     {
-        terminate();
+        reactor.reset(); // 先停止反应器线程,避免其在工作线程退出后继续提交回调
+        terminate_for(std::chrono::steady_clock::duration::max()); // 与terminate_for相同:一次唤醒所有线程并等待它们同时退出,而不是逐个join
+        worker_lists.clear(); // 线程均已退出,它们离开阻塞区时仍会访问补偿线程列表,因此先回收工作线程
+        while (true)
+        {
+            std::list<worker_thread> remaining;
+            {
+                std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+                if (compensation_workers.empty())
+                    break;
+                remaining.splice(remaining.end(), compensation_workers);
+            }
+        }
+    }
+
+    Reactor &ThreadPool::get_reactor()
+    {
+        std::lock_guard<std::mutex> lock(reactor_mutex);
+        if (!reactor)
+        {
+            reactor = std::make_unique<Reactor>(*this);
+        }
+        return *reactor;
     }
 
     void ThreadPool::pause_with_status_lock()
@@ -36,6 +75,11 @@ namespace my_thread_poll
         {
             worker.pause();
         }
+        std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+        for (auto &worker : compensation_workers)
+        {
+            worker.pause();
+        }
     }
 
     void ThreadPool::resume_with_status_lock()
@@ -59,6 +103,11 @@ namespace my_thread_poll
         {
             worker.resume();
         }
+        std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+        for (auto &worker : compensation_workers)
+        {
+            worker.resume();
+        }
     }
 
 
@@ -81,13 +130,110 @@ namespace my_thread_poll
             throw std::runtime_error("unknown status");
         }
         std::shared_lock<std::shared_mutex> lock(task_queue_mutex);
-        while(!task_queue.empty())
+        empty_waiter_count.fetch_add(1);
+        while(task_count.load() > 0 || local_task_count.load() > 0)
         {
             task_queue_cv_empty.wait(lock);  //在任务队列不为空前阻塞当前线程，将更多的cpu资源分配给任务队列中任务
         }
+        empty_waiter_count.fetch_sub(1);
+        lock.unlock();  //终止时需要获取task_queue_mutex来唤醒工作线程
         terminate_with_status_lock();
     }
 
+    /*
+    shutdown_until用于有时间上限的关闭,工作流程如下:
+    1.将线程池置为SHUTDOWN状态,不再接收新任务;处于暂停状态时先恢复,让工作线程继续执行队列中的任务
+    2.等待任务队列为空或到达截止时间
+    3.终止所有工作线程,并将共享任务队列、截止时间分片、各个类别队列与各个本地队列中剩余的任务取出返回,调用者可以将其交给其他线程池或持久化
+    正在执行的任务不会被中断,它们在返回后继续执行完毕;与取出任务同时发生的出队只会让任务被执行或被返回其中之一
+    */
+    std::vector<pooled_task> ThreadPool::shutdown_until_with_status_lock(std::chrono::steady_clock::time_point deadline)
+    {
+        std::vector<pooled_task> remaining;
+        switch (status.load())
+        {
+        case status_t::TERMINATED:
+        case status_t::TERMINATING:
+            return remaining;
+        case status_t::PAUSED:
+            resume_with_status_lock();
+        case status_t::RUNNING:
+            status.store(status_t::SHUTDOWN);
+            break;
+        case status_t::SHUTDOWN:
+            break;
+        default:
+            throw std::runtime_error("unknown status");
+        }
+        std::shared_lock<std::shared_mutex> lock(task_queue_mutex);
+        empty_waiter_count.fetch_add(1);
+        while(task_count.load() > 0 || local_task_count.load() > 0)
+        {
+            if(task_queue_cv_empty.wait_until(lock, deadline) == std::cv_status::timeout)
+                break;
+        }
+        empty_waiter_count.fetch_sub(1);
+        lock.unlock();
+        terminate_with_status_lock();
+        for(std::size_t i = 0; i < shard_count; ++i)
+        {
+            task_shard &shard = task_shards[i];
+            std::unique_lock<std::mutex> shard_lock(shard.mutex);
+            std::size_t count = shard.queue.size();
+            while(!shard.queue.empty())
+            {
+                remaining.push_back(std::move(shard.queue.front().task));
+                shard.queue.pop();
+            }
+            shard.size.fetch_sub(count, std::memory_order_relaxed);
+            task_count.fetch_sub(count);
+        }
+        for(std::size_t i = 0; i < shard_count; ++i)
+        {
+            deadline_shard &shard = deadline_shards[i];
+            std::unique_lock<std::mutex> shard_lock(shard.mutex);
+            std::size_t count = shard.heap.size();
+            std::sort_heap(shard.heap.begin(), shard.heap.end(), deadline_later());  //按截止时间从早到晚返回
+            for(auto it = shard.heap.rbegin(); it != shard.heap.rend(); ++it)
+            {
+                remaining.push_back(std::move(it->task));
+            }
+            shard.heap.clear();
+            shard.earliest.store(std::chrono::steady_clock::time_point::max().time_since_epoch().count(), std::memory_order_relaxed);
+            deadline_task_count.fetch_sub(count);
+            task_count.fetch_sub(count);
+        }
+        for(std::size_t i = 1; i < task_class_count.load(std::memory_order_acquire); ++i)
+        {
+            task_class_t &cls = task_classes[i];
+            std::unique_lock<std::mutex> class_lock(cls.mutex);
+            std::size_t count = cls.queue.size();
+            while(!cls.queue.empty())
+            {
+                remaining.push_back(std::move(cls.queue.front()));
+                cls.queue.pop();
+            }
+            cls.size.fetch_sub(count, std::memory_order_relaxed);
+            task_count.fetch_sub(count);
+        }
+        std::shared_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+        for(worker_thread *worker : worker_index)
+        {
+            std::unique_lock<std::mutex> local_lock(worker->local_mutex);
+            std::size_t count = worker->local_queue.size();
+            while(!worker->local_queue.empty())
+            {
+                remaining.push_back(std::move(worker->local_queue.front().task));
+                worker->local_queue.pop();
+            }
+            worker->local_size.fetch_sub(count);
+            local_task_count.fetch_sub(count);
+        }
+        worker_lists_lock.unlock();
+        notify_empty_waiters();
+        return remaining;
+    }
+
     void ThreadPool::terminate_with_status_lock()
     {
         switch (status.load())
@@ -109,7 +255,15 @@ namespace my_thread_poll
         {
             worker.terminate();
         }
-        task_queue_cv.notify_all();
+        {
+            std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+            for(auto &worker : compensation_workers)
+            {
+                worker.terminate();
+            }
+            active_compensation_count = 0;
+        }
+        notify_all_workers();
         status.store(status_t::TERMINATED);
     }
 
@@ -128,10 +282,12 @@ namespace my_thread_poll
             throw std::runtime_error("unknown status");
         }
         std::shared_lock<std::shared_mutex> lock(task_queue_mutex);
-        while(!task_queue.empty())
+        empty_waiter_count.fetch_add(1);
+        while(task_count.load() > 0 || local_task_count.load() > 0)
         {
             task_queue_cv_empty.wait(lock);  //在任务队列为空前阻塞当亲线程，将更多的cpu资源分配给任务队列中任务
-        } 
+        }
+        empty_waiter_count.fetch_sub(1);
     }
 
     void ThreadPool::wait()
@@ -164,12 +320,125 @@ namespace my_thread_poll
         shutdown_with_wait_status_lock(true);
     }
 
+    std::vector<pooled_task> ThreadPool::shutdown_for(std::chrono::steady_clock::duration timeout)
+    {
+        return shutdown_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    std::vector<pooled_task> ThreadPool::shutdown_until(std::chrono::steady_clock::time_point deadline)
+    {
+        std::shared_lock<std::shared_mutex> lock(status_mutex);
+        return shutdown_until_with_status_lock(deadline);
+    }
+
     void ThreadPool::terminate()
     {
         std::shared_lock<std::shared_mutex> lock(status_mutex);
         terminate_with_status_lock();
     }
 
+    /*
+    terminate_for的工作流程如下:
+    1.与terminate相同,将线程池与所有工作线程置为终止状态并一次性唤醒所有阻塞的线程,各线程同时退出
+    2.等待所有线程退出,而不是逐个join:每个线程退出时增加exit_epoch,等待者据此判断是否需要重新检查
+    3.回收已经退出的线程;超时仍在执行任务的线程保留在列表中,在析构时回收
+    */
+    bool ThreadPool::terminate_for(std::chrono::steady_clock::duration timeout)
+    {
+        auto start = std::chrono::steady_clock::now();
+        terminate();
+        auto deadline = start;  //start + timeout在超时时间取极值时会溢出,因此截断到时间点的范围内
+        if(timeout >= std::chrono::steady_clock::time_point::max() - start)
+            deadline = std::chrono::steady_clock::time_point::max();
+        else if(timeout > std::chrono::steady_clock::duration::zero())
+            deadline = start + timeout;
+        bool all_exited = wait_workers_exit_until(deadline);
+        reap_exited_workers();
+        teardown_time.store((std::chrono::steady_clock::now() - start).count());
+        return all_exited;
+    }
+
+    std::chrono::steady_clock::duration ThreadPool::get_teardown_time()
+    {
+        return std::chrono::steady_clock::duration(teardown_time.load());
+    }
+
+    bool ThreadPool::wait_workers_exit_until(std::chrono::steady_clock::time_point deadline)
+    {
+        std::chrono::microseconds pause(1);
+        while (true)
+        {
+            std::size_t epoch = exit_epoch.load();
+            std::size_t running = 0;
+            {
+                std::shared_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+                for (auto &worker : worker_lists)
+                {
+                    running += !worker.exited.load();
+                }
+            }
+            {
+                std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+                for (auto &worker : compensation_workers)
+                {
+                    running += !worker.exited.load();
+                }
+            }
+            if (running == 0)
+            {
+                return true;
+            }
+            // 在exit_epoch至少增加running之前不需要重新扫描线程列表
+            std::size_t current;
+            while ((current = exit_epoch.load()) - epoch < running)
+            {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= deadline)
+                {
+                    return false;
+                }
+                if (deadline == std::chrono::steady_clock::time_point::max())
+                {
+                    exit_epoch.wait(current);
+                    continue;
+                }
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(pause, deadline - now)); // std::atomic::wait不支持超时
+                pause = std::min(pause * 2, std::chrono::microseconds(1000));
+            }
+        }
+    }
+
+    void ThreadPool::reap_exited_workers()
+    {
+        std::list<worker_thread> exited;
+        {
+            std::unique_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+            for (auto it = worker_lists.begin(); it != worker_lists.end();)
+            {
+                auto next = std::next(it);
+                if (it->exited.load())
+                {
+                    exited.splice(exited.end(), worker_lists, it);
+                }
+                it = next;
+            }
+            rebuild_worker_index();
+        }
+        {
+            std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+            for (auto it = compensation_workers.begin(); it != compensation_workers.end();)
+            {
+                auto next = std::next(it);
+                if (it->exited.load())
+                {
+                    exited.splice(exited.end(), compensation_workers, it);
+                }
+                it = next;
+            }
+        }
+        exited.clear(); // 线程均已退出,join不会阻塞
+    }
+
     void ThreadPool::add_thread(std::size_t count)
     {
         std::shared_lock<std::shared_mutex> status_lock(status_mutex);
@@ -186,11 +455,21 @@ namespace my_thread_poll
             throw std::runtime_error("[thread_pool::add_thread][error]: invalid thread pool state");
         }
         std::unique_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+        if(lazy_start)
+        {
+            lazy_thread_count.fetch_add(count);
+            worker_lists_lock.unlock();
+            if(get_task_count() > 0) //已有排队任务时立即启动一个线程,其余线程仍在后续任务到来时启动
+            {
+                notify_one_worker();
+            }
+            return;
+        }
         for(std::size_t i = 0; i < count; ++i)
         {
             worker_lists.emplace_back(this);
         }
-        
+        rebuild_worker_index();
     }
 
     void ThreadPool::remove_thread(std::size_t count)
@@ -209,6 +488,9 @@ namespace my_thread_poll
             throw std::runtime_error("[thread_pool::add_thread][error]: invalid thread pool state");
         }
         std::unique_lock<std::shared_mutex> work_lists_lock(worker_lists_mutex);
+        std::size_t lazy_removed = std::min(count, lazy_thread_count.load()); //先减少尚未启动的线程
+        lazy_thread_count.fetch_sub(lazy_removed);
+        count -= lazy_removed;
         count=std::min(count, worker_lists.size());
         auto it=worker_lists.end();
         for(int i=0;i<count;++i)
@@ -216,14 +498,732 @@ namespace my_thread_poll
             it--;
             it->terminate();
         }
-        task_queue_cv.notify_all(); //唤醒所有线程,让线程自身查看状态
-        worker_lists.erase(it, worker_lists.end()); //删除线程
+        notify_all_workers(); //唤醒所有线程,让线程自身查看状态
+        std::list<worker_thread> removed;
+        removed.splice(removed.end(), worker_lists, it, worker_lists.end());
+        rebuild_worker_index();
+        work_lists_lock.unlock();
+        status_lock.unlock();
+        //在锁外等待被删除的线程退出:它们正在执行的任务可能调用submit_to等需要worker_lists_mutex的接口
+        //removed析构时等待线程退出,被删除线程本地队列中的任务会转移到共享任务队列中
+    }
+
+    void ThreadPool::check_submit_with_status_lock(std::size_t class_id, bool shard_queue)
+    {
+        switch (status.load())
+        {
+            case status_t::TERMINATED:
+            throw std::runtime_error("ThreadPool is terminated");
+            case status_t::TERMINATING:
+            throw std::runtime_error("ThreadPool is terminating");
+            case status_t::PAUSED:
+            throw std::runtime_error("ThreadPool is paused");
+            case status_t::SHUTDOWN:
+            throw std::runtime_error("ThreadPool is shutdown");
+            case status_t::RUNNING:
+            break;
+        }
+        //max_task_count只限制默认类别的分片队列,其他类别的上限由push_class_task在类别队列的锁内检查
+        std::size_t limit = max_task_count.load();
+        bool check_overload = class_id == 0 && shard_queue && overloaded.load(std::memory_order_relaxed);
+        if(class_id != 0 || (limit == 0 && !check_overload))
+        {
+            return;
+        }
+        std::size_t queued = get_shard_task_count();
+        if(limit > 0 && queued >= limit)
+        {
+            task_classes[0].rejected.fetch_add(1, std::memory_order_relaxed);
+            throw std::runtime_error("ThreadPool is full");
+        }
+        //过载状态由分片中任务的排队时间得出,只拒绝加入分片的提交;
+        //分片已经取空时积压已经消化完,即使最后一个分片任务出队时类别队列中仍有任务,也在这里恢复
+        if(check_overload)
+        {
+            if(queued == 0)
+            {
+                overloaded.store(false, std::memory_order_relaxed);
+                return;
+            }
+            task_classes[0].rejected.fetch_add(1, std::memory_order_relaxed);
+            throw std::runtime_error("ThreadPool is overloaded");
+        }
+    }
+
+    std::size_t ThreadPool::get_shard_task_count()
+    {
+        std::size_t queued = 0;
+        for(std::size_t i = 0; i < shard_count; ++i)
+        {
+            queued += task_shards[i].size.load(std::memory_order_relaxed);
+        }
+        return queued;
+    }
+
+    /*
+    push_task将任务放入当前线程对应的分片,工作流程如下:
+    1.按照当前线程id的哈希值选择分片,同一个生产者总是使用同一个分片,保证同一生产者提交的任务先进先出
+    2.只锁住所选分片,不同生产者之间不再竞争同一把锁
+    3.先增加任务总数再检查空闲线程数量,只有存在空闲线程时才获取task_queue_mutex并唤醒,
+    工作线程则是先登记为空闲再检查任务总数,两者的顺序保证不会错过唤醒
+    */
+    void ThreadPool::push_task(pooled_task &&task, bool sheddable)
+    {
+        std::size_t index = shard_count == 1 ? 0 : std::hash<std::thread::id>{}(std::this_thread::get_id()) % shard_count;
+        task_shard &shard = task_shards[index];
+        {
+            THREAD_POOL_PROFILE_SCOPE(ENQUEUE);
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            std::chrono::steady_clock::time_point enqueue_time;
+            if(admission_target.load(std::memory_order_relaxed) > 0)
+                enqueue_time = std::chrono::steady_clock::now();
+            shard.queue.push({std::move(task), enqueue_time, sheddable});
+            shard.size.fetch_add(1, std::memory_order_relaxed);
+            ++shard.submitted;
+            lock.unlock();
+            task_count.fetch_add(1);
+        }
+        THREAD_POOL_PROFILE_SCOPE(WAKEUP);
+        notify_one_worker();
+    }
+
+    void ThreadPool::notify_one_worker()
+    {
+        if(idle_worker_count.load() > 0)
+        {
+            std::unique_lock<std::shared_mutex> task_lock(task_queue_mutex);
+            task_lock.unlock();
+            task_queue_cv.notify_one();  //唤醒一个线程来执行当前任务
+        }
+        else if(lazy_thread_count.load(std::memory_order_relaxed) > 0)
+        {
+            start_lazy_worker();
+        }
+    }
+
+    void ThreadPool::start_lazy_worker()
+    {
+        // 阻塞加锁:持有worker_lists_mutex的操作都不会在锁内等待工作线程(remove_thread在锁外回收被删除的线程),
+        // 因此工作线程上的提交者加锁不会死锁;若加锁失败就返回,没有已启动工作线程时任务可能永远不被执行
+        std::unique_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+        if(lazy_thread_count.load() == 0)
+            return;
+        status_t current_status = status.load();  //终止与暂停在加锁前修改状态,加锁后检查可以保证新线程不会错过这些操作
+        if(current_status != status_t::RUNNING && current_status != status_t::SHUTDOWN)
+            return;
+        worker_lists.emplace_back(this);
+        lazy_thread_count.fetch_sub(1);
+        rebuild_worker_index();
+    }
+
+    /*
+    prewarm的工作流程如下:
+    1.将尚未启动的工作线程分成若干组,由多个临时线程并行创建,再一并加入工作线程列表
+    2.向每个工作线程的本地队列提交一个预热任务并等待完成:预热任务触及一段栈空间,
+    从每个slab大小类中分配并释放一个块以创建线程缓存,并创建内存池、触及其初始缓冲区
+    */
+    void ThreadPool::prewarm()
+    {
+        {
+            std::shared_lock<std::shared_mutex> status_lock(status_mutex);
+            if(status.load() != status_t::RUNNING) // 预热任务通过submit_to提交,只有运行状态才接收
+                throw std::runtime_error("[thread_pool::prewarm][error]: cannot prewarm the thread pool in this state");
+            std::unique_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+            std::size_t pending = lazy_thread_count.exchange(0);
+            if(pending > 0)
+            {
+                std::size_t groups = std::min<std::size_t>(pending, std::max(1u, std::thread::hardware_concurrency()));
+                std::vector<std::list<worker_thread>> started(groups);
+                std::vector<std::exception_ptr> errors(groups);
+                auto start_group = [&](std::size_t group)
+                {
+                    try
+                    {
+                        for(std::size_t i = group; i < pending; i += groups)
+                            started[group].emplace_back(this);
+                    }
+                    catch (...)
+                    {
+                        errors[group] = std::current_exception();
+                    }
+                };
+                std::vector<std::thread> starters;
+                for(std::size_t group = 1; group < groups; ++group)
+                {
+                    try
+                    {
+                        starters.emplace_back(start_group, group);
+                    }
+                    catch (...) // 无法创建临时线程时由当前线程创建该组
+                    {
+                        start_group(group);
+                    }
+                }
+                start_group(0);
+                for(auto &starter : starters)
+                    starter.join();
+                std::size_t created = 0;
+                for(auto &group : started)
+                {
+                    created += group.size();
+                    worker_lists.splice(worker_lists.end(), group);
+                }
+                lazy_thread_count.fetch_add(pending - created);
+                rebuild_worker_index();
+                for(auto &error : errors)
+                {
+                    if(error)
+                        std::rethrow_exception(error);
+                }
+            }
+        }
+        std::size_t thread_count = get_thread_count();
+        std::vector<std::future<void>> warmed;
+        warmed.reserve(thread_count);
+        for(std::size_t i = 0; i < thread_count; ++i)
+        {
+            warmed.push_back(submit_to(i, []() { current_worker->warm_up(); }));
+        }
+        for(auto &future : warmed)
+        {
+            future.get();
+        }
+    }
+
+    void ThreadPool::push_class_task(std::size_t class_id, pooled_task &&task, bool sheddable)
+    {
+        if(class_id == 0)
+        {
+            push_task(std::move(task), sheddable);
+            return;
+        }
+        if(class_id >= task_class_count.load(std::memory_order_acquire))
+            throw std::out_of_range("[thread_pool::push_class_task][error]: invalid task class");
+        task_class_t &cls = task_classes[class_id];
+        {
+            THREAD_POOL_PROFILE_SCOPE(ENQUEUE);
+            std::unique_lock<std::mutex> lock(cls.mutex);
+            std::size_t limit = cls.max_task_count.load();
+            if(limit > 0 && cls.queue.size() >= limit)
+            {
+                cls.rejected.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("ThreadPool task class is full");
+            }
+            cls.queue.emplace(std::move(task));
+            cls.size.fetch_add(1, std::memory_order_relaxed);
+            ++cls.submitted;
+            lock.unlock();
+            task_count.fetch_add(1);
+        }
+        THREAD_POOL_PROFILE_SCOPE(WAKEUP);
+        notify_one_worker();
+    }
+
+    bool ThreadPool::pop_task(worker_thread *worker, pooled_task &task)
+    {
+        if(worker->local_size.load() > 0 && worker->pop_local(task, std::chrono::steady_clock::time_point::max()))
+            return true;
+        if(deadline_task_count.load() > 0 && pop_deadline_task(task))
+            return true;
+        if(task_class_count.load(std::memory_order_acquire) > 1 ? pop_weighted_task(worker, task) : pop_shard_task(worker, task))
+            return true;
+        return local_task_count.load() > 0 && steal_task(worker, task);
+    }
+
+    void ThreadPool::push_deadline_task(std::chrono::steady_clock::time_point deadline, pooled_task &&task)
+    {
+        std::size_t index = shard_count == 1 ? 0 : std::hash<std::thread::id>{}(std::this_thread::get_id()) % shard_count;
+        deadline_shard &shard = deadline_shards[index];
+        {
+            THREAD_POOL_PROFILE_SCOPE(ENQUEUE);
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.heap.push_back({deadline, shard.next_seq++, std::move(task)});
+            std::push_heap(shard.heap.begin(), shard.heap.end(), deadline_later());
+            shard.earliest.store(shard.heap.front().deadline.time_since_epoch().count(), std::memory_order_relaxed);
+            lock.unlock();
+            deadline_task_count.fetch_add(1);
+            task_count.fetch_add(1);
+        }
+        THREAD_POOL_PROFILE_SCOPE(WAKEUP);
+        notify_one_worker();
+    }
+
+    bool ThreadPool::pop_deadline_task(pooled_task &task)
+    {
+        constexpr auto empty = std::chrono::steady_clock::time_point::max().time_since_epoch().count();
+        for(std::size_t attempt = 0; attempt < shard_count; ++attempt)  //选中的分片可能已被其他线程取空,换一个分片重试
+        {
+            deadline_shard *chosen = nullptr;
+            std::chrono::steady_clock::rep earliest = empty;
+            for(std::size_t i = 0; i < shard_count; ++i)
+            {
+                std::chrono::steady_clock::rep candidate = deadline_shards[i].earliest.load(std::memory_order_relaxed);
+                if(candidate < earliest)
+                {
+                    earliest = candidate;
+                    chosen = &deadline_shards[i];
+                }
+            }
+            if(!chosen)
+                return false;
+            std::unique_lock<std::mutex> lock(chosen->mutex);
+            if(chosen->heap.empty())
+                continue;
+            std::pop_heap(chosen->heap.begin(), chosen->heap.end(), deadline_later());
+            task = std::move(chosen->heap.back().task);
+            chosen->heap.pop_back();
+            chosen->earliest.store(chosen->heap.empty() ? empty : chosen->heap.front().deadline.time_since_epoch().count(), std::memory_order_relaxed);
+            lock.unlock();
+            deadline_task_count.fetch_sub(1);
+            if(task_count.fetch_sub(1) == 1 && local_task_count.load() == 0)
+            {
+                notify_empty_waiters();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool ThreadPool::drop_if_expired(std::chrono::steady_clock::time_point deadline)
+    {
+        if(!drop_expired.load(std::memory_order_relaxed) || std::chrono::steady_clock::now() <= deadline)
+            return false;
+        expired_task_count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void ThreadPool::set_drop_expired(bool drop)
+    {
+        drop_expired.store(drop);
+    }
+
+    std::size_t ThreadPool::get_expired_task_count()
+    {
+        return expired_task_count.load();
+    }
+
+    /*
+    准入控制借鉴CoDel的队列管理方式,以排队时间而不是队列长度判断过载:
+    1.开启后,任务加入分片时记录时间,工作线程取出任务时计算排队时间并更新当前统计区间内的最小值
+    2.每经过一个统计区间,若区间内的最小排队时间超过目标,说明队列中存在无法消化的积压而不是短暂的突发,
+    此时进入过载状态,新提交的任务被拒绝;最小排队时间回到目标以内或分片被取空时自动恢复(类别队列中剩余的任务不影响恢复)
+    3.开启丢弃时,过载期间取出的排队时间超过目标、且由submit/async/submit_class(类别0)提交的任务直接丢弃,
+    返回的future得到broken_promise异常;post提交的任务没有future,调用者无从得知被丢弃,
+    Strand、Pipeline、Reactor等组件也通过post提交后续任务,丢弃会使它们永远挂起,因此这些任务只参与统计,不会被丢弃
+    只有分片中的任务参与统计,过载时也只拒绝加入分片的提交;submit_to、截止时间与非默认类别的提交不受影响
+    */
+    void ThreadPool::set_admission_control(std::chrono::steady_clock::duration target, std::chrono::steady_clock::duration interval, bool shed)
+    {
+        admission_interval.store(std::max(interval, std::chrono::steady_clock::duration(1)).count());
+        admission_shed.store(shed);
+        admission_window_min.store(std::chrono::steady_clock::duration::max().count());
+        admission_window_start.store(std::chrono::steady_clock::now().time_since_epoch().count());
+        admission_target.store(std::max(target, std::chrono::steady_clock::duration::zero()).count());
+        overloaded.store(false);
+    }
+
+    bool ThreadPool::is_overloaded()
+    {
+        return overloaded.load();
+    }
+
+    std::size_t ThreadPool::get_shed_task_count()
+    {
+        return shed_task_count.load();
+    }
+
+    bool ThreadPool::admission_sample(std::chrono::steady_clock::time_point enqueue_time, bool sheddable)
+    {
+        std::chrono::steady_clock::rep target = admission_target.load(std::memory_order_relaxed);
+        if(target == 0 || enqueue_time == std::chrono::steady_clock::time_point())
+            return false;
+        std::chrono::steady_clock::rep now = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::chrono::steady_clock::rep sojourn = now - enqueue_time.time_since_epoch().count();
+        std::chrono::steady_clock::rep current_min = admission_window_min.load(std::memory_order_relaxed);
+        while(sojourn < current_min && !admission_window_min.compare_exchange_weak(current_min, sojourn, std::memory_order_relaxed));
+        std::chrono::steady_clock::rep window_start = admission_window_start.load(std::memory_order_relaxed);
+        if(now - window_start >= admission_interval.load(std::memory_order_relaxed)
+            && admission_window_start.compare_exchange_strong(window_start, now, std::memory_order_relaxed))
+        {
+            std::chrono::steady_clock::rep window_min = admission_window_min.exchange(std::chrono::steady_clock::duration::max().count(), std::memory_order_relaxed);
+            overloaded.store(window_min > target, std::memory_order_relaxed); // 只有整个区间都存在积压时才进入过载
+        }
+        //分片已经取空时积压已经消化完;task_count还包括类别队列中的任务,不能用它判断
+        if(overloaded.load(std::memory_order_relaxed) && get_shard_task_count() == 0)
+        {
+            overloaded.store(false, std::memory_order_relaxed);
+        }
+        if(sheddable && admission_shed.load(std::memory_order_relaxed) && sojourn > target && overloaded.load(std::memory_order_relaxed))
+        {
+            shed_task_count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    bool ThreadPool::pop_shard_task(worker_thread *worker, pooled_task &task)
+    {
+        for(std::size_t i = 0; i < shard_count; ++i)
+        {
+            task_shard &shard = task_shards[(worker->home_shard + i) % shard_count];
+            while(shard.size.load(std::memory_order_relaxed) > 0) // 取出的任务被丢弃时从同一分片继续取
+            {
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                if(shard.queue.empty())
+                    break;
+                shard_task_t &front = shard.queue.front();
+                task = std::move(front.task);
+                std::chrono::steady_clock::time_point enqueue_time = front.enqueue_time;
+                bool sheddable = front.sheddable;
+                shard.queue.pop();
+                shard.size.fetch_sub(1, std::memory_order_relaxed);
+                ++shard.executed;
+                lock.unlock();
+                if(task_count.fetch_sub(1) == 1 && local_task_count.load() == 0)
+                {
+                    notify_empty_waiters();
+                }
+                if(!admission_sample(enqueue_time, sheddable))
+                    return true;
+                task.reset(); // 丢弃:future得到broken_promise异常
+            }
+        }
+        return false;
+    }
+
+    bool ThreadPool::pop_class_task(std::size_t class_id, pooled_task &task)
+    {
+        task_class_t &cls = task_classes[class_id];
+        std::unique_lock<std::mutex> lock(cls.mutex);
+        if(cls.queue.empty())
+            return false;
+        task = std::move(cls.queue.front());
+        cls.queue.pop();
+        cls.size.fetch_sub(1, std::memory_order_relaxed);
+        ++cls.executed;
+        lock.unlock();
+        if(task_count.fetch_sub(1) == 1 && local_task_count.load() == 0)
+        {
+            notify_empty_waiters();
+        }
+        return true;
+    }
+
+    /*
+    赤字轮询:drr_current指向当前类别,drr_deficit为其本轮剩余的配额;
+    当前类别为空或配额用完时轮到下一个类别,并将配额重置为该类别的权重,空类别不累积配额
+    最多访问每个类别两次(第一次可能只是用完上一轮剩余的配额),仍未取到任务说明所有类别都为空
+    */
+    bool ThreadPool::pop_weighted_task(worker_thread *worker, pooled_task &task)
+    {
+        std::size_t classes = task_class_count.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(drr_mutex);
+        for(std::size_t visited = 0; visited <= 2 * classes; ++visited)
+        {
+            std::size_t id = drr_current % classes;
+            bool has_task = false;
+            if(id == 0)
+            {
+                for(std::size_t i = 0; i < shard_count && !has_task; ++i)
+                    has_task = task_shards[i].size.load(std::memory_order_relaxed) > 0;
+            }
+            else
+            {
+                has_task = task_classes[id].size.load(std::memory_order_relaxed) > 0;
+            }
+            if(has_task && drr_deficit > 0)
+            {
+                --drr_deficit;
+                lock.unlock();
+                if(id == 0 ? pop_shard_task(worker, task) : pop_class_task(id, task))
+                    return true;
+                lock.lock();  //任务已被其他线程取走,继续轮询
+                continue;
+            }
+            drr_current = (id + 1) % classes;
+            drr_deficit = std::max<std::size_t>(task_classes[drr_current].weight.load(), 1);
+        }
+        return false;
+    }
+
+    std::size_t ThreadPool::add_task_class(std::size_t weight, std::size_t max_task_count)
+    {
+        std::unique_lock<std::mutex> lock(task_class_mutex);
+        std::size_t id = task_class_count.load();
+        if(id >= max_task_classes)
+            throw std::runtime_error("[thread_pool::add_task_class][error]: too many task classes");
+        task_classes[id].weight.store(std::max<std::size_t>(weight, 1));
+        task_classes[id].max_task_count.store(max_task_count);
+        task_class_count.store(id + 1, std::memory_order_release);  //初始化完成后再发布
+        return id;
+    }
+
+    void ThreadPool::set_task_class(std::size_t class_id, std::size_t weight, std::size_t max_task_count)
+    {
+        if(class_id >= task_class_count.load(std::memory_order_acquire))
+            throw std::out_of_range("[thread_pool::set_task_class][error]: invalid task class");
+        task_classes[class_id].weight.store(std::max<std::size_t>(weight, 1));
+        if(class_id == 0)
+            set_max_task_count(max_task_count);
+        else
+            task_classes[class_id].max_task_count.store(max_task_count);
+    }
+
+    ThreadPool::task_class_stats ThreadPool::get_task_class_stats(std::size_t class_id)
+    {
+        if(class_id >= task_class_count.load(std::memory_order_acquire))
+            throw std::out_of_range("[thread_pool::get_task_class_stats][error]: invalid task class");
+        task_class_t &cls = task_classes[class_id];
+        task_class_stats stats{cls.weight.load(), cls.max_task_count.load(), 0, 0, 0, cls.rejected.load()};
+        if(class_id == 0)  //默认类别的任务存放在各个分片中
+        {
+            stats.max_task_count = max_task_count.load();
+            for(std::size_t i = 0; i < shard_count; ++i)
+            {
+                std::unique_lock<std::mutex> lock(task_shards[i].mutex);
+                stats.queued += task_shards[i].queue.size();
+                stats.submitted += task_shards[i].submitted;
+                stats.executed += task_shards[i].executed;
+            }
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(cls.mutex);
+            stats.queued = cls.queue.size();
+            stats.submitted = cls.submitted;
+            stats.executed = cls.executed;
+        }
+        return stats;
+    }
+
+    bool ThreadPool::steal_task(worker_thread *worker, pooled_task &task)
+    {
+        // 增删工作线程时会持有worker_lists_mutex并等待被删除的线程退出,这里只尝试加锁,避免与之形成死锁
+        std::shared_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex, std::try_to_lock);
+        if(!worker_lists_lock.owns_lock())
+            return false;
+        auto enqueued_before = std::chrono::steady_clock::now() - std::chrono::steady_clock::duration(steal_delay.load());
+        for(worker_thread *victim : worker_index)
+        {
+            if(victim != worker && victim->local_size.load() > 0 && victim->pop_local(task, enqueued_before))
+                return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::push_local_task(std::size_t index, pooled_task &&task)
+    {
+        std::shared_lock<std::shared_mutex> worker_lists_lock(worker_lists_mutex);
+        if(worker_index.empty())
+        {
+            worker_lists_lock.unlock();
+            push_task(std::move(task));
+            return;
+        }
+        worker_thread *worker = worker_index[index % worker_index.size()];
+        std::size_t last_local_count;
+        {
+            THREAD_POOL_PROFILE_SCOPE(ENQUEUE);
+            std::unique_lock<std::mutex> local_lock(worker->local_mutex);
+            worker->local_queue.push({std::move(task), std::chrono::steady_clock::now()});
+            last_local_count = local_task_count.fetch_add(1);
+            worker->local_size.fetch_add(1);
+        }
+        THREAD_POOL_PROFILE_SCOPE(WAKEUP);
+        // 目标线程正在等待任务时需要唤醒它;本地任务从无到有时也唤醒空闲线程,让它们改为定时等待以便窃取超时的任务
+        if(worker->idle.load() || (last_local_count == 0 && idle_worker_count.load() > 0))
+        {
+            notify_all_workers();
+        }
+    }
+
+    /*
+    阻塞区的工作方式如下:
+    1.工作线程进入阻塞区时,若没有空闲的工作线程,且补偿线程数量少于阻塞中的工作线程数量、未达到上限,则创建一个补偿线程
+    2.离开阻塞区时,若补偿线程多于阻塞中的工作线程,则要求其中一个补偿线程在执行完当前任务后退出
+    3.已退出的补偿线程在下一次进入或离开阻塞区时回收;为避免与终止、增删线程时的等待形成死锁,回收时不持有任何锁等待线程退出
+    补偿线程只执行共享任务队列中的任务,不拥有可被submit_to选中的本地队列
+    */
+    bool ThreadPool::is_current_worker()
+    {
+        return current_worker != nullptr && current_worker->pool == this;
+    }
+
+    bool ThreadPool::run_pending_task()
+    {
+        status_t current_status = status.load();
+        if(current_status != status_t::RUNNING && current_status != status_t::SHUTDOWN)
+            return false;
+        pooled_task task;
+        if(!pop_task(current_worker, task))
+            return false;
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            handle_exception(std::current_exception());
+        }
+        return true;
+    }
+
+    bool ThreadPool::begin_blocking()
+    {
+        if(!is_current_worker())
+            return false;
+        std::size_t blocked = blocked_worker_count.fetch_add(1) + 1;
+        reap_compensation_workers();
+        if(idle_worker_count.load() > 0) // 还有空闲线程可以接手任务,无需补偿
+            return true;
+        std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+        status_t current_status = status.load();
+        if((current_status == status_t::RUNNING || current_status == status_t::SHUTDOWN)
+            && active_compensation_count < blocked && active_compensation_count < max_compensation_count.load())
+        {
+            compensation_workers.emplace_back(this);
+            ++active_compensation_count;
+        }
+        return true;
+    }
+
+    void ThreadPool::end_blocking()
+    {
+        std::size_t blocked = blocked_worker_count.fetch_sub(1) - 1;
+        bool retired = false;
+        {
+            std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+            if(active_compensation_count > blocked)
+            {
+                for(auto &worker : compensation_workers)
+                {
+                    auto worker_status = worker.status.load();
+                    if(worker_status != worker_thread::status_t::TERMINATING && worker_status != worker_thread::status_t::TERMINATED)
+                    {
+                        worker.terminate();
+                        --active_compensation_count;
+                        retired = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if(retired)
+        {
+            notify_all_workers(); // 唤醒可能正在等待任务的补偿线程,让它查看自身状态后退出
+        }
+        reap_compensation_workers();
+    }
+
+    void ThreadPool::reap_compensation_workers()
+    {
+        std::list<worker_thread> finished;
+        {
+            std::unique_lock<std::mutex> compensation_lock(compensation_mutex);
+            for(auto it = compensation_workers.begin(); it != compensation_workers.end();)
+            {
+                auto next = std::next(it);
+                if(it->status.load() == worker_thread::status_t::TERMINATED)
+                {
+                    finished.splice(finished.end(), compensation_workers, it);
+                }
+                it = next;
+            }
+        }
+        // finished析构时等待线程退出,这些线程已经离开工作循环,等待时间很短
+    }
+
+    ThreadPool::blocking_section::blocking_section(ThreadPool &pool) : pool(pool.begin_blocking() ? &pool : nullptr) {}
+
+    ThreadPool::blocking_section::~blocking_section()
+    {
+        if(pool)
+        {
+            pool->end_blocking();
+        }
+    }
+
+    std::pmr::memory_resource *ThreadPool::current_arena()
+    {
+        if(current_worker == nullptr)
+            return std::pmr::get_default_resource();
+        return current_worker->get_arena();
+    }
+
+    void ThreadPool::set_arena(std::size_t size, std::pmr::memory_resource *upstream)
+    {
+        arena_size.store(size);
+        arena_upstream.store(upstream ? upstream : std::pmr::new_delete_resource());
+    }
+
+    void ThreadPool::set_max_compensation_count(std::size_t count)
+    {
+        max_compensation_count.store(count);
+    }
+
+    void ThreadPool::rebuild_worker_index()
+    {
+        worker_index.clear();
+        for(auto &worker : worker_lists)
+        {
+            worker_index.push_back(&worker);
+        }
+    }
+
+    void ThreadPool::set_steal_delay(std::chrono::nanoseconds delay)
+    {
+        steal_delay.store(std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay).count());
+    }
+
+    void ThreadPool::notify_empty_waiters()
+    {
+        if(empty_waiter_count.load() == 0)
+            return;
+        std::unique_lock<std::shared_mutex> task_lock(task_queue_mutex);
+        task_lock.unlock();
+        task_queue_cv_empty.notify_all();  //任务队列为空,唤醒等待任务完成的线程
+    }
+
+    void ThreadPool::notify_all_workers()
+    {
+        // 先获取一次task_queue_mutex,保证正在检查状态、准备阻塞的工作线程不会错过本次唤醒
+        std::unique_lock<std::shared_mutex> task_lock(task_queue_mutex);
+        task_lock.unlock();
+        task_queue_cv.notify_all();
+    }
+
+    void ThreadPool::set_exception_handler(std::function<void(std::exception_ptr)> handler)
+    {
+        std::unique_lock<std::shared_mutex> lock(exception_handler_mutex);
+        exception_handler = std::move(handler);
+    }
+
+    void ThreadPool::handle_exception(std::exception_ptr e)
+    {
+        std::shared_lock<std::shared_mutex> lock(exception_handler_mutex);
+        if(exception_handler)
+        {
+            exception_handler(e);
+            return;
+        }
+        lock.unlock();
+        try
+        {
+            std::rethrow_exception(e);
+        }
+        catch (const std::exception &ex)
+        {
+            std::cerr<<ex.what()<<std::endl;
+        }
+        catch (...)
+        {
+            std::cerr<<"unknown exception"<<std::endl;
+        }
     }
 
     std::size_t ThreadPool::get_task_count()
     {
-        std::shared_lock<std::shared_mutex> lock(task_queue_mutex);
-        return task_queue.size();
+        return task_count.load() + local_task_count.load();
     }
 
     std::size_t ThreadPool::get_thread_count()
@@ -232,4 +1232,10 @@ namespace my_thread_poll
         return worker_lists.size();
     }
 
+    std::size_t ThreadPool::get_configured_thread_count()
+    {
+        std::shared_lock<std::shared_mutex> lock(worker_lists_mutex); //启动线程时在锁内同时修改两者
+        return worker_lists.size() + lazy_thread_count.load();
+    }
+
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "../../include/threadPool.h"
 #include <iostream>
+#include <cstring>
 
 namespace my_thread_poll
 {
@@ -11,8 +12,22 @@ namespace my_thread_poll
     - 根据线程池状态变更，如接收到暂停、恢复、终止等指令，工作线程调整自身状态并执行相应操作
     */
 
-    ThreadPool::worker_thread::worker_thread(ThreadPool *pool):pool(pool),status(status_t::RUNNING),sem(0),thread(
+    thread_local ThreadPool::worker_thread *ThreadPool::current_worker = nullptr;
+
+    ThreadPool::worker_thread::worker_thread(ThreadPool *pool):pool(pool),status(status_t::RUNNING),sem(0),
+    home_shard(pool->next_home_shard.fetch_add(1, std::memory_order_relaxed) % pool->shard_count),thread(
     [this](){
+        struct exit_guard // 线程函数以任何方式返回时登记退出,析构与terminate_for据此一次性等待所有线程
+        {
+            worker_thread *worker;
+            ~exit_guard()
+            {
+                worker->exited.store(true);
+                worker->pool->exit_epoch.fetch_add(1);
+                worker->pool->exit_epoch.notify_all();
+            }
+        } guard{this};
+        current_worker = this;
         while (true)
         {
             // 实现线程状态的判断，决定是否由该线程执行任务
@@ -51,7 +66,8 @@ namespace my_thread_poll
 
             // 判断队列是否为空，如果为空则阻塞当前线程
             std::unique_lock<std::shared_mutex> unique_lock_task(this->pool->task_queue_mutex);
-            while (this->pool->task_queue.empty())
+            bool steal_attempt = false; // 定时等待结束后尝试窃取其他线程本地队列中的任务
+            while (!steal_attempt && this->pool->task_count.load() == 0 && this->local_size.load() == 0)
             {
                 while (true)
                 {
@@ -87,7 +103,28 @@ namespace my_thread_poll
                         break;
                     }
                 }
-                this->pool->task_queue_cv.wait(unique_lock_task);
+                if (!unique_lock_task.owns_lock()) // 从暂停中恢复后需要重新获取任务队列锁
+                {
+                    unique_lock_task.lock();
+                }
+                // 先登记为空闲再检查任务数量,与push_task中先增加任务数量再检查空闲线程数量相对应,避免错过唤醒
+                this->pool->idle_worker_count.fetch_add(1);
+                this->idle.store(true);
+                if (this->pool->task_count.load() == 0 && this->local_size.load() == 0)
+                {
+                    THREAD_POOL_PROFILE_SCOPE(IDLE);
+                    if (this->pool->local_task_count.load() > 0) // 其他线程的本地队列中有任务,定时醒来尝试窃取
+                    {
+                        this->pool->task_queue_cv.wait_for(unique_lock_task, std::chrono::steady_clock::duration(this->pool->steal_delay.load()));
+                        steal_attempt = true;
+                    }
+                    else
+                    {
+                        this->pool->task_queue_cv.wait(unique_lock_task);
+                    }
+                }
+                this->idle.store(false);
+                this->pool->idle_worker_count.fetch_sub(1);
                 while (true)
                 {
                     if (!unique_lock_status.owns_lock())
@@ -121,22 +158,35 @@ namespace my_thread_poll
                         break;
                     }
                 }
+                if (!unique_lock_task.owns_lock())
+                {
+                    unique_lock_task.lock();
+                }
             }
-            // 尝试取出任务并执行
+            unique_lock_task.unlock();
+            // 尝试取出任务并执行,依次从本地队列、所属分片、其他分片中取任务,最后尝试窃取;没有取到说明任务已被其他线程取走
             try
             {
-                auto task = this->pool->task_queue.front();
-                this->pool->task_queue.pop();
-                if (this->pool->task_queue.empty())
+                pooled_task task;
+                bool popped;
+                {
+                    THREAD_POOL_PROFILE_SCOPE(DEQUEUE);
+                    popped = this->pool->pop_task(this, task);
+                }
+                if (!popped)
                 {
-                    this->pool->task_queue_cv_empty.notify_all();
+                    continue;
                 }
-                unique_lock_task.unlock();
+                THREAD_POOL_PROFILE_SCOPE(EXECUTE);
                 task();
             }
-            catch (const std::exception &e)
+            catch (...)
             {
-                std::cerr<<e.what()<<std::endl;
+                this->pool->handle_exception(std::current_exception());
+            }
+            if (this->arena_used) // 任务(以及它在等待时帮助执行的任务)已经结束,整体释放内存池
+            {
+                this->reset_arena();
             }
         }
     }){}
@@ -148,11 +198,98 @@ namespace my_thread_poll
         {
             if(last_status == status_t::PAUSE)
             {
-                this->pool->task_queue_cv.notify_all();  //唤醒所有阻塞的线程,避免析构时阻塞
+                this->pool->notify_all_workers();  //唤醒所有阻塞的线程,避免析构时阻塞
             }
             thread.join();
         }
+        // 本地队列中尚未执行的任务转移到共享任务队列,由其他工作线程执行
+        while (!local_queue.empty())
+        {
+            pooled_task task = std::move(local_queue.front().task);
+            local_queue.pop();
+            local_size.fetch_sub(1);
+            this->pool->push_task(std::move(task));
+            this->pool->local_task_count.fetch_sub(1);
+        }
+    }
+
+    bool ThreadPool::worker_thread::pop_local(pooled_task &task, std::chrono::steady_clock::time_point enqueued_before)
+    {
+        std::unique_lock<std::mutex> local_lock(this->local_mutex);
+        if (local_queue.empty() || local_queue.front().enqueue_time > enqueued_before)
+        {
+            return false;
+        }
+        task = std::move(local_queue.front().task);
+        local_queue.pop();
+        local_size.fetch_sub(1);
+        local_lock.unlock();
+        if (this->pool->local_task_count.fetch_sub(1) == 1 && this->pool->task_count.load() == 0)
+        {
+            this->pool->notify_empty_waiters();
+        }
+        return true;
+    }
+    std::pmr::memory_resource *ThreadPool::worker_thread::get_arena()
+    {
+        arena_used = true;
+        if (!arena)
+        {
+            std::size_t size = pool->arena_size.load();
+            if (size != arena_buffer_size)
+            {
+                arena_buffer.reset(size > 0 ? new std::byte[size] : nullptr);
+                arena_buffer_size = size;
+            }
+            arena_upstream = pool->arena_upstream.load();
+            if (arena_buffer_size > 0)
+                arena.emplace(arena_buffer.get(), arena_buffer_size, arena_upstream);
+            else
+                arena.emplace(arena_upstream);
+        }
+        return &*arena;
+    }
+
+    void ThreadPool::worker_thread::reset_arena()
+    {
+        arena_used = false;
+        if (pool->arena_size.load() != arena_buffer_size || pool->arena_upstream.load() != arena_upstream)
+        {
+            arena.reset(); // 配置已经修改,下一次使用时按新配置重新创建
+        }
+        else
+        {
+            arena->release();
+        }
     }
+
+    void ThreadPool::worker_thread::warm_up()
+    {
+        if (warmed)
+            return;
+        warmed = true;
+        volatile unsigned char stack[64 * 1024]; // 按页触及一段栈空间
+        for (std::size_t i = 0; i < sizeof(stack); i += 4096)
+        {
+            stack[i] = 0;
+        }
+        void *blocks[slab_cache::class_count];
+        for (std::size_t i = 0; i < slab_cache::class_count; ++i)
+        {
+            blocks[i] = slab_cache::allocate(slab_cache::min_block_size << i);
+        }
+        for (void *block : blocks)
+        {
+            slab_cache::deallocate(block);
+        }
+        get_arena();
+        if (arena_buffer)
+        {
+            std::memset(arena_buffer.get(), 0, arena_buffer_size);
+        }
+        reset_arena();
+    }
+
     void ThreadPool::worker_thread::resume_with_status_lock()
     {
         switch (this->status.load())
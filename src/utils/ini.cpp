@@ -3,12 +3,24 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iterator>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 
 namespace utils{
         //支持各个类型的构造函数
         Value::Value(){}
-        Value::Value(const std::string& value): m_value(value){}
+        Value::Value(const std::string& value): m_value(value)
+        {
+            parse();
+        }
         Value::Value(const int value)
         {
             *this=value;   
@@ -22,70 +34,92 @@ namespace utils{
             *this=value;
         }
 
-        Value::Value(const char* value)
+        Value::Value(const char* value): m_value(value)
         {
-            m_value=value;
+            parse();
         }
         Value::~Value(){}
 
+        /*
+        parse按照原先atoi/atof的规则解析文本:跳过开头的空白与'+',只解析开头合法的部分,无法解析时为0
+        */
+        void Value::parse()
+        {
+            const char* first=m_value.data();
+            const char* last=first+m_value.size();
+            while(first!=last&&std::isspace(static_cast<unsigned char>(*first))) ++first;
+            if(first!=last&&*first=='+'&&(last-first<2||first[1]!='-')) ++first;
+            m_int=0;
+            if(std::from_chars(first,last,m_int).ec!=std::errc())
+            {
+                m_int=0;
+            }
+            m_double=0;
+            if(std::from_chars(first,last,m_double).ec!=std::errc())
+            {
+                m_double=0;
+            }
+            m_bool=m_value=="true";
+        }
+
         //赋值操作,支持任意类型
         Value& Value::operator=(const std::string& value)
         {
             m_value = value;
+            m_type = Type::STRING;
+            parse();
             return *this;
         }
 
         Value& Value::operator=(const char* value)
         {
             m_value=value;
+            m_type = Type::STRING;
+            parse();
             return *this;
         }
         Value& Value::operator=(const int value)
         {
-            std::stringstream ss;
-            ss<<value;
-            m_value=ss.str();
+            char buf[16];
+            auto res=std::to_chars(buf,buf+sizeof(buf),value);
+            m_value.assign(buf,res.ptr);
+            m_type=Type::INT;
+            m_int=value;
+            m_double=value;
+            m_bool=false;
             return *this;
         }
         Value& Value::operator=(const double value)
         {
-            std::stringstream ss;
-            ss<<value;
-            m_value=ss.str();
+            char buf[32];
+            auto res=std::to_chars(buf,buf+sizeof(buf),value); //最短且可以无损还原的表示
+            m_value.assign(buf,res.ptr);
+            m_type=Type::DOUBLE;
+            parse();
+            m_double=value;
             return *this;   
         }
         Value& Value:: operator=(const bool value)
         {
-            std::stringstream ss;
-            ss<<value;
-            m_value=ss.str();
+            m_value=value?"true":"false"; //与operator bool的解析规则一致
+            m_type=Type::BOOL;
+            m_int=0;
+            m_double=0;
+            m_bool=value;
             return *this;
         }
 
         //对于值的判断
-        bool Value:: operator==(const Value& other)
+        bool Value:: operator==(const Value& other) const
         {
             return m_value==other.m_value;
         }
-        bool Value:: operator!=(const Value& other)
+        bool Value:: operator!=(const Value& other) const
         {
             return m_value!=other.m_value;
         }
 
-        //这里实现可以将Value对象转换为任意类型
-        Value::operator int()
-        {
-            return atoi(m_value.c_str());
-        }
-        Value::operator double()
-        {
-            return atof(m_value.c_str());
-        }
-        Value::operator bool()
-        {
-            return m_value=="true"?true:false;
-        }
-        Value::operator std::string()
+        Value::operator std::string() const
         {
             return m_value;
         }
@@ -105,43 +139,143 @@ namespace utils{
 
         }
 
+        static constexpr std::size_t mmap_threshold=4*1024*1024; //不小于该大小的文件才使用mmap
+
+        static bool read_file(int fd,std::size_t size_hint,std::string& content) //通过read读入整个文件,文件在读取期间变长时继续读到末尾
+        {
+            content.resize(std::max<std::size_t>(size_hint,1));
+            std::size_t length=0;
+            while(true)
+            {
+                if(length==content.size())
+                    content.resize(content.size()*2);
+                ssize_t n=::read(fd,content.data()+length,content.size()-length);
+                if(n<0)
+                {
+                    if(errno==EINTR)
+                        continue;
+                    return false;
+                }
+                if(n==0)
+                    break;
+                length+=static_cast<std::size_t>(n);
+            }
+            content.resize(length);
+            return true;
+        }
+
+        /*
+        load的工作流程如下:
+        1.配置文件大小的普通文件通过read读入缓冲区,不小于mmap_threshold的大文件通过mmap映射到内存,
+        两者都以std::string_view逐行原地解析,不再为每一行复制字符串
+        2.只有存入的分区名、键与值才创建std::string
+        3.管道等无法映射的文件整体读入内存后使用同样的解析过程
+        注意:解析映射区域期间若文件被其他进程截断,访问截断部分会收到SIGBUS,MAP_PRIVATE也无法避免;
+        热加载时配置文件可能随时被改写,因此小文件一律使用read,大文件应先写入临时文件再重命名替换
+        映射解析完成后再次检查文件大小,发生变化时改用read重新加载
+        */
         bool IniFile:: load(const std::string& filename)
         {
             m_sections.clear();
-            std::ifstream fin(filename);
+            int fd=::open(filename.c_str(),O_RDONLY|O_CLOEXEC);
+            if(fd==-1)
+            {
+                std::cout<<"can not open file:"<<filename<<std::endl;
+                return false;
+            }
+            struct stat st;
+            if(fstat(fd,&st)==-1||!S_ISREG(st.st_mode))
+            {
+                ::close(fd);
+                return load_stream(filename);
+            }
+            std::size_t size=static_cast<std::size_t>(st.st_size);
+            if(size>=mmap_threshold)
+            {
+                void* data=mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0);
+                if(data!=MAP_FAILED)
+                {
+                    madvise(data,size,MADV_SEQUENTIAL);
+                    bool res=parse(std::string_view(static_cast<const char*>(data),size));
+                    munmap(data,size);
+                    struct stat after;
+                    if(fstat(fd,&after)==0&&after.st_size==st.st_size&&after.st_mtim.tv_sec==st.st_mtim.tv_sec&&after.st_mtim.tv_nsec==st.st_mtim.tv_nsec)
+                    {
+                        ::close(fd);
+                        return res;
+                    }
+                    m_sections.clear(); //解析期间文件被修改,结果可能不完整
+                }
+                if(lseek(fd,0,SEEK_SET)==-1)
+                {
+                    ::close(fd);
+                    return load_stream(filename);
+                }
+            }
+            std::string content;
+            bool ok=read_file(fd,size,content);
+            ::close(fd);
+            if(!ok)
+            {
+                std::cout<<"can not read file:"<<filename<<std::endl;
+                return false;
+            }
+            return parse(content);
+        }
+
+        bool IniFile::load_stream(const std::string& filename)
+        {
+            std::ifstream fin(filename,std::ios::binary);
             if(!fin)
             {
                 std::cout<<"can not open file:"<<filename<<std::endl;
                 return false;
             }
-            std::string strline;
-            std::string section;
-            while(getline(fin,strline))
+            std::string content((std::istreambuf_iterator<char>(fin)),std::istreambuf_iterator<char>());
+            return parse(content);
+        }
+
+        bool IniFile::parse(std::string_view data)
+        {
+            std::string_view section;
+            bool in_section=false; //是否已经遇到过分区头,分区头之前的键值存入名为空的分区
+            std::vector<Section::value_type> entries; //当前分区中尚未排序的键值
+            auto flush=[&]()
+            {
+                if(in_section||!entries.empty())
+                {
+                    m_sections[section].assign_unsorted(std::move(entries));
+                }
+                entries.clear();
+            };
+            while(!data.empty())
             {
+                std::size_t end=data.find('\n');
+                std::string_view strline=data.substr(0,end);
+                data.remove_prefix(end==std::string_view::npos?data.size():end+1);
                 if(strline.empty()) continue;
                 if(strline[0]=='#') continue; //跳过注释
                 if(strline[0]=='[') //做分区处理
                 {
-                    int pos=strline.find_first_of(']');
-                    if(pos==-1)
+                    std::size_t pos=strline.find_first_of(']');
+                    if(pos==std::string_view::npos)
                     {
+                        flush();
                         return false;
                     }
-                    section=trim(strline.substr(1,pos-1));
-                    section=trim(section);
-                    m_sections[section]=Section();
+                    flush();
+                    section=trim_view(strline.substr(1,pos-1)); //重复的分区头与原先一样清空该分区
+                    in_section=true;
                 }
                 else
                 {
-                    int pos=strline.find('=');
-                    std::string key=trim(strline.substr(0,pos));
-                    trim(key);
-                    std::string value=trim(strline.substr(pos+1));
-                    trim(value);
-                    m_sections[section][key]=value;
-                }   
+                    std::size_t pos=strline.find('=');
+                    std::string_view key=trim_view(strline.substr(0,pos));
+                    std::string_view value=trim_view(pos==std::string_view::npos?strline:strline.substr(pos+1)); //没有'='的行与原先一样,键与值均为整行
+                    entries.emplace_back(std::string(key),Value(std::string(value)));
+                }
             }
-            fin.close();
+            flush();
             return true;
         }
 
@@ -157,15 +291,14 @@ namespace utils{
             return true;
         }
 
-        std::string IniFile::trim(std::string s)
+        std::string_view IniFile::trim_view(std::string_view s)
         {
-            if(s.empty())
+            std::size_t begin=s.find_first_not_of(" \r\n");
+            if(begin==std::string_view::npos)
             {
-                return "";
+                return std::string_view();
             }
-            s.erase(0,s.find_first_not_of(" \r\n"));
-            s.erase(s.find_last_not_of(" \r\n")+1);
-            return s;
+            return s.substr(begin,s.find_last_not_of(" \r\n")-begin+1);
         }
 
         void IniFile::show()
@@ -185,36 +318,42 @@ namespace utils{
             m_sections.clear();
         }
 
-        Value& IniFile::get(const std::string& section,const std::string&key)
+        Value& IniFile::get(std::string_view section,std::string_view key)
         {
             return m_sections[section][key];
         }
 
-        void IniFile::set(const std::string& section,const std::string& key,const Value& value)
+        const Value* IniFile::find(std::string_view section,std::string_view key) const
+        {
+            auto it=m_sections.find(section);
+            if(it==m_sections.end()) return nullptr;
+            auto it2=it->second.find(key);
+            return it2==it->second.end()?nullptr:&it2->second;
+        }
+
+        void IniFile::set(std::string_view section,std::string_view key,const Value& value)
         {
             m_sections[section][key]=value;
         }
 
-        bool IniFile::remove(const std::string& section,const std::string& key)
+        bool IniFile::remove(std::string_view section,std::string_view key)
         {
-            if(m_sections.empty())  return false;
-            if(!has(section)) return false;
-            if(!has(section,key)) return false;
-            m_sections[section].erase(key);
-            return true;
+            auto it=m_sections.find(section);
+            if(it==m_sections.end()) return false;
+            return it->second.erase(key)>0;
         }
 
-        bool IniFile::has(const std::string& section)
+        bool IniFile::has(std::string_view section) const
         {
             return m_sections.find(section)!=m_sections.end();
         }
 
-        bool IniFile::has(const std::string& section,const std::string& key)
+        bool IniFile::has(std::string_view section,std::string_view key) const
         {
-            return m_sections[section].find(key)!=m_sections[section].end();
+            return find(section,key)!=nullptr;
         }
 
-        Section& IniFile::operator[](const std::string& section)
+        Section& IniFile::operator[](std::string_view section)
         {
             return m_sections[section];
         }
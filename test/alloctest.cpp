@@ -0,0 +1,68 @@
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include "threadPool.h"
+
+// 替换全局operator new/delete,统计稳态下提交任务时的堆分配次数,出现任何堆分配即失败
+static std::atomic<bool> counting{false};
+static std::atomic<std::size_t> allocations{0};
+static std::atomic<std::size_t> deallocations{0};
+
+static void *counted_alloc(std::size_t size, std::size_t align)
+{
+    if (counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    void *p = align > alignof(std::max_align_t) ? std::aligned_alloc(align, (size + align - 1) / align * align) : std::malloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void counted_free(void *p) noexcept
+{
+    if (p && counting.load(std::memory_order_relaxed))
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void *operator new(std::size_t size) { return counted_alloc(size, 0); }
+void *operator new[](std::size_t size) { return counted_alloc(size, 0); }
+void *operator new(std::size_t size, std::align_val_t align) { return counted_alloc(size, static_cast<std::size_t>(align)); }
+void *operator new[](std::size_t size, std::align_val_t align) { return counted_alloc(size, static_cast<std::size_t>(align)); }
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+
+int main()
+{
+    constexpr int rounds = 10000;
+    my_thread_poll::ThreadPool pool(4);
+    std::atomic<int> done{0};
+    auto run = [&]()
+    {
+        for (int i = 0; i < rounds; ++i)
+        {
+            pool.submit([](int x) { return x + 1; }, i).get();
+            pool.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load() < rounds)
+            std::this_thread::yield();
+        done = 0;
+    };
+
+    run(); // 预热:填充各线程的slab缓存与队列节点
+    counting = true;
+    run();
+    counting = false;
+
+    std::cout << "allocations:" << allocations.load() << " deallocations:" << deallocations.load() << std::endl;
+    return allocations.load() == 0 && deallocations.load() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "threadPool.h"
+#include "poolFuture.h"
+
+// 用法: async_bench [提交次数] [线程数量],默认200000次,4个线程
+// 对比submit(std::future)与async(pool_future)逐个提交并等待结果的往返耗时
+template <typename Func>
+double measure(Func &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    my_thread_poll::ThreadPool pool(threads);
+    long long sink = 0;
+
+    auto run_submit = [&]()
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            sink += pool.submit([](std::size_t x) { return static_cast<long long>(x); }, i).get();
+    };
+    auto run_async = [&]()
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            sink += pool.async([](std::size_t x) { return static_cast<long long>(x); }, i).get();
+    };
+    run_submit(); // 预热slab缓存与队列节点
+    run_async();
+
+    double submit_ms = measure(run_submit);
+    double async_ms = measure(run_async);
+    std::cout << "round trips:" << n << " threads:" << threads << std::endl;
+    std::cout << "submit:" << submit_ms << "ms async:" << async_ms << "ms speedup:" << submit_ms / async_ms
+              << " checksum:" << sink << std::endl;
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+#include "ini.h"
+
+// ini库行为测试,任一检查失败时返回非零
+static int failures = 0;
+
+#define CHECK(expr)                                                                       \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(expr))                                                                      \
+        {                                                                                 \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed" << std::endl; \
+            ++failures;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+static std::string temp_file(const std::string &name, const std::string &content)
+{
+    std::string filename = "/tmp/ini_check_" + std::to_string(::getpid()) + "_" + name + ".ini";
+    std::ofstream(filename, std::ios::binary) << content;
+    return filename;
+}
+
+static std::string padded(const std::string &content) // 在末尾补充注释行,使文件大小超过mmap_threshold(4MiB)
+{
+    std::string result = content;
+    std::string comment = "#" + std::string(1022, '-') + "\n";
+    while (result.size() < 5 * 1024 * 1024)
+        result += comment;
+    return result;
+}
+
+static void test_read_and_mmap_agree() // read与mmap两条加载路径的解析结果一致
+{
+    const std::string content =
+        "top = 1\n"          // 分区头之前的键存入名为空的分区
+        "[server]\n"
+        "port = 80\n"
+        "host=example\n"
+        "[client]\n"
+        "timeout=3\n"
+        "[server]\n"         // 重复的分区头清空该分区
+        "port = 8080\n"
+        "bare line\n"        // 没有'='的行,键与值均为整行
+        "# comment\n";
+    std::string small = temp_file("small", content);
+    std::string large = temp_file("large", padded(content));
+
+    utils::IniFile by_read, by_mmap;
+    CHECK(by_read.load(small));
+    CHECK(by_mmap.load(large));
+    CHECK(by_read.str() == by_mmap.str());
+    for (utils::IniFile *ini : {&by_read, &by_mmap})
+    {
+        CHECK(ini->find("", "top") && std::string(*ini->find("", "top")) == "1");
+        CHECK(ini->find("server", "port") && int(*ini->find("server", "port")) == 8080);
+        CHECK(!ini->has("server", "host"));
+        CHECK(ini->find("server", "bare line") && std::string(*ini->find("server", "bare line")) == "bare line");
+        CHECK(ini->find("client", "timeout") && int(*ini->find("client", "timeout")) == 3);
+    }
+
+    std::string broken_small = temp_file("broken_small", "a=1\n[broken\nb=2\n");
+    std::string broken_large = temp_file("broken_large", padded("a=1\n") + "[broken\nb=2\n");
+    utils::IniFile broken;
+    CHECK(!broken.load(broken_small));
+    CHECK(!broken.load(broken_large));
+
+    for (const std::string &filename : {small, large, broken_small, broken_large})
+        std::remove(filename.c_str());
+}
+
+static void test_flat_map_references_and_lookup() // FlatMap返回的引用在插入其他键后仍然有效,查找不插入,重复键保留最后一个
+{
+    utils::FlatMap<utils::Value> map;
+    utils::Value &kept = map["m"];
+    kept = 42;
+    for (int i = 0; i < 1000; ++i) // 大量插入会多次扩容并移动指针数组,节点本身不移动
+        map["k" + std::to_string(i)] = i;
+    CHECK(&map["m"] == &kept);
+    CHECK(int(kept) == 42);
+
+    std::size_t size = map.size();
+    CHECK(map.find("missing") == map.end());
+    CHECK(map.count("missing") == 0);
+    CHECK(map.size() == size);
+
+    utils::IniFile ini;
+    utils::Value &port = ini.get("server", "port");
+    port = 80;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ini.set("server", "key" + std::to_string(i), i);
+        ini.set("section" + std::to_string(i), "key", i);
+    }
+    CHECK(&ini.get("server", "port") == &port);
+    CHECK(int(port) == 80);
+    std::size_t keys = ini["server"].size();
+    CHECK(!ini.has("server", "missing"));
+    CHECK(ini.find("server", "missing") == nullptr);
+    CHECK(!ini.has("missing"));
+    CHECK(ini.find("missing", "key") == nullptr);
+    CHECK(ini["server"].size() == keys);
+    CHECK(!ini.has("missing"));
+
+    std::vector<utils::Section::value_type> entries;
+    entries.emplace_back("b", utils::Value(1));
+    entries.emplace_back("a", utils::Value(2));
+    entries.emplace_back("b", utils::Value(3));
+    entries.emplace_back("a", utils::Value(4));
+    entries.emplace_back("b", utils::Value(5));
+    utils::Section section;
+    section.assign_unsorted(std::move(entries));
+    CHECK(section.size() == 2);
+    CHECK(section.begin()->first == "a");
+    CHECK(int(section["a"]) == 4);
+    CHECK(int(section["b"]) == 5);
+}
+
+static void test_value_parsing_and_type() // Value的数值解析与原先的atoi/atof一致,type()记录最近一次赋值的类型
+{
+    for (const char *text : {"42", "  42", "\t-7", "+5", "+-5", "-+5", "3.5abc", "  2.25e1x", "abc", "", " ", "+", "true"})
+    {
+        utils::Value value(text);
+        CHECK(int(value) == std::atoi(text));
+        CHECK(double(value) == std::atof(text));
+    }
+    CHECK(int(utils::Value("  12")) == 12);
+    CHECK(int(utils::Value("+5")) == 5);
+    CHECK(int(utils::Value("+-5")) == 0);
+    CHECK(int(utils::Value("3.5abc")) == 3);
+    CHECK(double(utils::Value("3.5abc")) == 3.5);
+    CHECK(int(utils::Value("abc")) == 0 && double(utils::Value("abc")) == 0);
+    CHECK(bool(utils::Value("true")) && !bool(utils::Value("yes")));
+
+    utils::Value half(2.5);
+    std::string text = half;
+    CHECK(text == "2.5");
+    utils::Value parsed(text);
+    CHECK(double(parsed) == 2.5);
+    CHECK(int(parsed) == 2);
+    CHECK(double(half) == 2.5 && int(half) == 2);
+
+    utils::Value value;
+    CHECK(value.type() == utils::Value::Type::STRING);
+    value = 3;
+    CHECK(value.type() == utils::Value::Type::INT && std::string(value) == "3");
+    value = 0.5;
+    CHECK(value.type() == utils::Value::Type::DOUBLE && std::string(value) == "0.5");
+    value = true;
+    CHECK(value.type() == utils::Value::Type::BOOL && std::string(value) == "true");
+    value = std::string("7");
+    CHECK(value.type() == utils::Value::Type::STRING && int(value) == 7);
+    value = 1;
+    value = "8";
+    CHECK(value.type() == utils::Value::Type::STRING && int(value) == 8);
+    CHECK(utils::Value(1).type() == utils::Value::Type::INT);
+    CHECK(utils::Value(1.0).type() == utils::Value::Type::DOUBLE);
+    CHECK(utils::Value(false).type() == utils::Value::Type::BOOL);
+    CHECK(utils::Value("x").type() == utils::Value::Type::STRING);
+    CHECK(utils::Value(std::string("x")).type() == utils::Value::Type::STRING);
+}
+
+int main()
+{
+    test_read_and_mmap_agree();
+    test_flat_map_references_and_lookup();
+    test_value_parsing_and_type();
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
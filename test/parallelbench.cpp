@@ -0,0 +1,52 @@
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include "threadPool.h"
+#include "parallelAlgorithm.h"
+
+// 用法: parallel_bench [元素数量] [线程数量],默认10^8个元素,线程数量取硬件并发数
+template <typename Func>
+double measure(Func &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+    std::size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+    my_thread_poll::ThreadPool pool(threads);
+
+    std::vector<int> data(n);
+    std::mt19937 rng(42);
+    for (auto &x : data)
+        x = static_cast<int>(rng());
+    std::vector<int> expected = data, actual = data, out(n);
+
+    double std_sort = measure([&]() { std::sort(expected.begin(), expected.end()); });
+    double par_sort = measure([&]() { my_thread_poll::parallel_sort(pool, actual.begin(), actual.end()); });
+    std::cout << "elements:" << n << " threads:" << threads << std::endl;
+    std::cout << "std::sort:" << std_sort << "ms parallel_sort:" << par_sort << "ms speedup:" << std_sort / par_sort
+              << (actual == expected ? "" : " MISMATCH") << std::endl;
+
+    double std_transform = measure([&]() { std::transform(data.begin(), data.end(), expected.begin(), [](int x) { return x / 3 + 1; }); });
+    double par_transform = measure([&]() { my_thread_poll::parallel_transform(pool, data.begin(), data.end(), actual.begin(), [](int x) { return x / 3 + 1; }); });
+    std::cout << "std::transform:" << std_transform << "ms parallel_transform:" << par_transform << "ms speedup:" << std_transform / par_transform
+              << (actual == expected ? "" : " MISMATCH") << std::endl;
+
+    double std_scan = measure([&]() { std::inclusive_scan(expected.begin(), expected.end(), out.begin()); });
+    double par_scan = measure([&]() { my_thread_poll::parallel_inclusive_scan(pool, actual.begin(), actual.end(), actual.begin()); });
+    std::cout << "std::inclusive_scan:" << std_scan << "ms parallel_inclusive_scan:" << par_scan << "ms speedup:" << std_scan / par_scan
+              << (actual == out ? "" : " MISMATCH") << std::endl;
+
+    std::ptrdiff_t std_count = 0, par_count = 0;
+    double std_count_ms = measure([&]() { std_count = std::count_if(data.begin(), data.end(), [](int x) { return x % 7 == 0; }); });
+    double par_count_ms = measure([&]() { par_count = my_thread_poll::parallel_count_if(pool, data.begin(), data.end(), [](int x) { return x % 7 == 0; }); });
+    std::cout << "std::count_if:" << std_count_ms << "ms parallel_count_if:" << par_count_ms << "ms speedup:" << std_count_ms / par_count_ms
+              << (std_count == par_count ? "" : " MISMATCH") << std::endl;
+}
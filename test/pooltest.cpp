@@ -0,0 +1,685 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <algorithm>
+#include <sys/eventfd.h>
+#include <string>
+#include <memory_resource>
+#include <random>
+#include <numeric>
+#include <functional>
+#include <stdexcept>
+#include "threadPool.h"
+#include "basicThreadPool.h"
+#include "strand.h"
+#include "configWatcher.h"
+#include "pipeline.h"
+#include "reactor.h"
+#include "poolFuture.h"
+#include "whenAll.h"
+#include "parallelAlgorithm.h"
+
+// 线程池行为测试,任一检查失败时返回非零
+static int failures = 0;
+
+#define CHECK(expr)                                                                       \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(expr))                                                                      \
+        {                                                                                 \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed" << std::endl; \
+            ++failures;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+template <typename Pred>
+static bool wait_until(Pred pred, std::chrono::milliseconds timeout = std::chrono::seconds(5)) // 等待条件成立,超时返回false
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred())
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static void test_submit_post()
+{
+    my_thread_poll::ThreadPool pool(2);
+    std::atomic<int> done{0};
+    CHECK(pool.submit([](int x) { return x * 2; }, 21).get() == 42);
+    for (int i = 0; i < 100; ++i)
+        pool.post([&done]() { done.fetch_add(1); });
+    CHECK(wait_until([&]() { return done.load() == 100; }));
+}
+
+static void test_remove_thread_submit_to() // 被删除线程上的任务调用submit_to时remove_thread不能死锁
+{
+    my_thread_poll::ThreadPool pool(2);
+    std::atomic<bool> started{false}, release{false}, removed{false};
+    std::atomic<int> inner{0};
+    auto blocker = pool.submit_to(1, [&]()
+    {
+        started = true;
+        while (!release.load())
+            std::this_thread::yield();
+        pool.submit_to(0, [&]() { inner.fetch_add(1); });
+    });
+    CHECK(wait_until([&]() { return started.load(); }));
+    std::thread remover([&]() { pool.remove_thread(1); removed = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 让remove_thread开始等待被删除的线程
+    release = true;
+    if (!wait_until([&]() { return removed.load(); }))
+    {
+        std::cerr << "remove_thread deadlocked" << std::endl;
+        std::_Exit(EXIT_FAILURE);
+    }
+    remover.join();
+    blocker.get();
+    CHECK(wait_until([&]() { return inner.load() == 1; }));
+    CHECK(pool.get_thread_count() == 1);
+}
+
+static void test_task_class_limits() // 各类别的上限互不影响,拒绝计入被拒绝的类别
+{
+    my_thread_poll::ThreadPool pool(1);
+    std::atomic<bool> started{false}, release{false};
+    std::atomic<int> done{0};
+    auto blocker = pool.submit([&]() { started = true; while (!release.load()) std::this_thread::yield(); });
+    CHECK(wait_until([&]() { return started.load(); })); // 先让唯一的工作线程被占用,任务才会留在队列中
+    std::size_t tenant = pool.add_task_class(1, 2);
+    std::size_t other = pool.add_task_class(1);
+    auto task = [&]() { done.fetch_add(1); };
+    pool.post_class(tenant, task);
+    pool.post_class(tenant, task);
+    bool rejected = false;
+    try { pool.post_class(tenant, task); } catch (const std::runtime_error &) { rejected = true; }
+    CHECK(rejected);
+    pool.post_class(other, task); // 一个类别已满不影响其他类别与默认类别
+    for (int i = 0; i < 3; ++i)
+        pool.post(task);
+    CHECK(pool.get_task_class_stats(tenant).rejected == 1);
+    CHECK(pool.get_task_class_stats(0).rejected == 0);
+    CHECK(pool.get_task_class_stats(other).rejected == 0);
+
+    pool.set_max_task_count(2); // 队列中已有3个默认类别的任务,超过上限后仍然拒绝
+    rejected = false;
+    try { pool.post(task); } catch (const std::runtime_error &) { rejected = true; }
+    CHECK(rejected);
+    CHECK(pool.get_task_class_stats(0).rejected == 1);
+    pool.post_class(other, task); // 默认类别的上限不限制其他类别
+    release = true;
+    blocker.get();
+    CHECK(wait_until([&]() { return done.load() == 7; }));
+}
+
+static void test_bounded_queue_capacity() // 并发提交时有上限的队列不能超过容量
+{
+    using namespace my_thread_poll;
+    basic_thread_pool<bounded_queue_policy<4>, function_task_policy, pausable_idle_policy<condvar_idle_policy>> pool(2);
+    pool.pause();
+    std::atomic<int> accepted{0};
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 8; ++i)
+    {
+        producers.emplace_back([&]()
+        {
+            for (int j = 0; j < 100; ++j)
+            {
+                try { pool.post([]() {}); accepted.fetch_add(1); } catch (const std::runtime_error &) {}
+            }
+        });
+    }
+    for (auto &producer : producers)
+        producer.join();
+    CHECK(accepted.load() == 4);
+    CHECK(pool.get_task_count() == 4);
+    pool.resume();
+    CHECK(pool.submit([](int x) { return x + 1; }, 1).get() == 2);
+}
+
+static void test_lazy_start() // 延迟启动的线程池在任务到来时启动工作线程,关闭后拒绝预热
+{
+    my_thread_poll::ThreadPool pool(4, 0, 1, true);
+    CHECK(pool.get_thread_count() == 0);
+    CHECK(pool.submit([]() { return 7; }).get() == 7);
+    CHECK(pool.get_thread_count() >= 1);
+    // 工作线程上的提交同样可以启动新线程
+    auto outer = pool.submit([&]() { return pool.submit([]() { return 1; }).get() + 1; });
+    CHECK(outer.get() == 2);
+    pool.prewarm();
+    CHECK(pool.get_thread_count() == 4);
+    pool.shutdown();
+    bool rejected = false;
+    try { pool.prewarm(); } catch (const std::runtime_error &) { rejected = true; }
+    CHECK(rejected);
+}
+
+static void test_terminate_for() // 超时时间取极值时不能溢出
+{
+    {
+        my_thread_poll::ThreadPool pool(2);
+        pool.post([]() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+        CHECK(pool.terminate_for(std::chrono::steady_clock::duration::max()));
+        CHECK(pool.get_teardown_time() >= std::chrono::steady_clock::duration::zero());
+    }
+    {
+        my_thread_poll::ThreadPool pool(2);
+        std::atomic<bool> release{false};
+        pool.post([&]() { while (!release.load()) std::this_thread::yield(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(!pool.terminate_for(std::chrono::steady_clock::duration::min())); // 不等待,正在执行任务的线程在析构时回收
+        release = true;
+    }
+}
+
+static void test_admission_shed() // 过载时只丢弃带future的提交,post与Strand的后续任务不会丢失
+{
+    my_thread_poll::ThreadPool pool(1);
+    pool.set_admission_control(std::chrono::milliseconds(1), std::chrono::milliseconds(1), true);
+    my_thread_poll::Strand strand(pool);
+    std::atomic<int> posted{0}, stranded{0};
+    auto blocker = pool.submit([]() { std::this_thread::sleep_for(std::chrono::milliseconds(30)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    auto slow = []() { std::this_thread::sleep_for(std::chrono::microseconds(200)); };
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 100; ++i)
+    {
+        futures.push_back(pool.submit(slow));
+        pool.post([&]() { slow(); posted.fetch_add(1); });
+        strand.post([&]() { stranded.fetch_add(1); });
+    }
+    blocker.get();
+    std::size_t broken = 0;
+    for (auto &future : futures)
+    {
+        try { future.get(); } catch (const std::future_error &) { ++broken; }
+    }
+    CHECK(wait_until([&]() { return posted.load() == 100 && stranded.load() == 100; }));
+    CHECK(pool.get_shed_task_count() > 0);
+    CHECK(broken == pool.get_shed_task_count());
+    CHECK(pool.submit_to(0, []() { return 3; }).get() == 3); // 本地队列不受过载拒绝影响
+}
+
+static void test_config_reload_lazy() // 重新加载配置时尚未启动的线程同样计入当前线程数量
+{
+    my_thread_poll::ThreadPool pool(4, 0, 1, true);
+    std::string filename = "/tmp/pool_test_" + std::to_string(::getpid()) + ".ini";
+    std::ofstream(filename) << "[thread_pool]\ninital_thread_count=2\n";
+    {
+        my_thread_poll::ConfigWatcher watcher(pool, filename);
+        CHECK(watcher.reload());
+        CHECK(pool.get_configured_thread_count() == 2);
+        std::ofstream(filename) << "[thread_pool]\ninital_thread_count=3\n";
+        CHECK(watcher.reload());
+        CHECK(pool.get_configured_thread_count() == 3);
+    }
+    std::remove(filename.c_str());
+}
+
+static void test_strand_ordering() // Strand按提交顺序串行执行;StrandGroup中同一个键的任务串行执行
+{
+    my_thread_poll::ThreadPool pool(4);
+    {
+        my_thread_poll::Strand strand(pool);
+        std::vector<int> order;
+        std::atomic<int> running{0}, overlap{0};
+        for (int i = 0; i < 1000; ++i)
+        {
+            strand.post([&, i]()
+            {
+                overlap += running.fetch_add(1) != 0;
+                order.push_back(i); // 串行执行,无需加锁
+                running.fetch_sub(1);
+            });
+        }
+        CHECK(strand.submit([]() { return 1; }).get() == 1);
+        CHECK(overlap.load() == 0);
+        bool in_order = order.size() == 1000;
+        for (int i = 0; in_order && i < 1000; ++i)
+            in_order = order[i] == i;
+        CHECK(in_order);
+    }
+    {
+        constexpr int keys = 8, per_key = 200;
+        my_thread_poll::StrandGroup<int> strands(pool, 3);
+        std::vector<std::atomic<int>> running(keys), next(keys);
+        std::atomic<int> violations{0};
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < per_key; ++i)
+        {
+            for (int key = 0; key < keys; ++key)
+            {
+                futures.push_back(strands.submit_ordered(key, [&, key, i]()
+                {
+                    violations += running[key].fetch_add(1) != 0;
+                    violations += next[key].exchange(i + 1) != i; // 同一个键按提交顺序执行
+                    running[key].fetch_sub(1);
+                }));
+            }
+        }
+        for (auto &future : futures)
+            future.get();
+        CHECK(violations.load() == 0);
+    }
+}
+
+static void test_pipeline_order_and_backpressure() // 同时处理的数据项不超过令牌数量,串行有序阶段按产生顺序处理
+{
+    my_thread_poll::ThreadPool pool(4);
+    constexpr int count = 200;
+    constexpr std::size_t max_tokens = 3;
+    struct item_t { int value; int result; };
+    int next_value = 0;
+    std::atomic<int> in_flight{0}, max_in_flight{0};
+    std::vector<int> output;
+    my_thread_poll::Pipeline<item_t> pipeline(pool);
+    pipeline.source([&](item_t &item)
+        {
+            if (next_value == count)
+                return false;
+            item.value = next_value++;
+            int current = in_flight.fetch_add(1) + 1;
+            int seen = max_in_flight.load();
+            while (current > seen && !max_in_flight.compare_exchange_weak(seen, current));
+            return true;
+        })
+        .stage(my_thread_poll::stage_mode::PARALLEL, [](item_t &item)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(item.value % 7 * 50)); // 打乱并行阶段的完成顺序
+            item.result = item.value * 2;
+        })
+        .stage(my_thread_poll::stage_mode::SERIAL_IN_ORDER, [&](item_t &item)
+        {
+            output.push_back(item.result);
+            in_flight.fetch_sub(1);
+        });
+    pipeline.run(max_tokens);
+    CHECK(max_in_flight.load() <= static_cast<int>(max_tokens));
+    bool in_order = output.size() == count;
+    for (int i = 0; in_order && i < count; ++i)
+        in_order = output[i] == i * 2;
+    CHECK(in_order);
+}
+
+static void test_shutdown_for_remaining() // shutdown_for返回的恰好是没有执行的任务
+{
+    my_thread_poll::ThreadPool pool(2);
+    std::atomic<bool> release{false};
+    std::atomic<int> started{0}, executed{0};
+    for (int i = 0; i < 2; ++i)
+        pool.post([&]() { started.fetch_add(1); while (!release.load()) std::this_thread::yield(); });
+    CHECK(wait_until([&]() { return started.load() == 2; }));
+    std::size_t tenant = pool.add_task_class(1);
+    auto task = [&]() { executed.fetch_add(1); };
+    for (int i = 0; i < 10; ++i)
+        pool.post(task);
+    for (int i = 0; i < 3; ++i)
+        pool.post_deadline(std::chrono::steady_clock::now() + std::chrono::seconds(10), task);
+    for (int i = 0; i < 2; ++i)
+        pool.post_class(tenant, task);
+    std::thread releaser([&]() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); release = true; });
+    auto remaining = pool.shutdown_for(std::chrono::milliseconds(20));
+    releaser.join();
+    CHECK(remaining.size() == 15);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(executed.load() == 0);
+    for (auto &remaining_task : remaining)
+        remaining_task();
+    CHECK(executed.load() == 15);
+}
+
+static void test_task_class_weights() // 赤字轮询按权重分配执行机会
+{
+    my_thread_poll::ThreadPool pool(1);
+    std::atomic<bool> started{false}, release{false};
+    auto blocker = pool.submit([&]() { started = true; while (!release.load()) std::this_thread::yield(); });
+    CHECK(wait_until([&]() { return started.load(); }));
+    std::size_t heavy = pool.add_task_class(3);
+    std::size_t light = pool.add_task_class(1);
+    std::vector<std::size_t> order; // 只有一个工作线程,按执行顺序记录类别
+    for (int i = 0; i < 60; ++i)
+    {
+        pool.post_class(heavy, [&]() { order.push_back(heavy); });
+        pool.post_class(light, [&]() { order.push_back(light); });
+    }
+    release = true;
+    blocker.get();
+    pool.wait();
+    CHECK(order.size() == 120);
+    std::size_t heavy_count = std::count(order.begin(), order.begin() + std::min<std::size_t>(order.size(), 40), heavy);
+    CHECK(heavy_count >= 28 && heavy_count <= 32); // 两个类别都有积压时执行次数之比为3:1
+}
+
+static void test_deadline_order_and_expiry() // 截止时间早的任务先执行,开启过期丢弃后已过期的任务不再执行
+{
+    my_thread_poll::ThreadPool pool(1);
+    pool.set_drop_expired(true);
+    std::atomic<bool> started{false}, release{false};
+    auto blocker = pool.submit([&]() { started = true; while (!release.load()) std::this_thread::yield(); });
+    CHECK(wait_until([&]() { return started.load(); })); // 截止时间任务优先于普通任务,需要先让工作线程被占用
+    auto now = std::chrono::steady_clock::now();
+    std::vector<int> order;
+    auto late = pool.submit_deadline(now + std::chrono::seconds(20), [&]() { order.push_back(2); });
+    auto early = pool.submit_deadline(now + std::chrono::seconds(10), [&]() { order.push_back(1); });
+    std::atomic<bool> expired_ran{false};
+    auto expired = pool.submit_deadline(now + std::chrono::milliseconds(1), [&]() { expired_ran = true; });
+    pool.post_deadline(now + std::chrono::milliseconds(1), [&]() { expired_ran = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    release = true;
+    blocker.get();
+    late.get();
+    early.get();
+    bool threw = false;
+    try { expired.get(); } catch (const my_thread_poll::deadline_expired_error &) { threw = true; }
+    CHECK(threw);
+    pool.wait();
+    CHECK(!expired_ran.load());
+    CHECK(pool.get_expired_task_count() == 2);
+    CHECK(order == std::vector<int>({1, 2}));
+}
+
+static void test_reactor_eventfd() // eventfd可读时回调在工作线程上执行
+{
+    my_thread_poll::ThreadPool pool(2);
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    CHECK(fd >= 0);
+    std::atomic<std::uint64_t> received{0};
+    std::atomic<bool> on_worker{false};
+    std::thread::id caller = std::this_thread::get_id();
+    pool.get_reactor().add(fd, EPOLLIN, [&](int ready_fd, std::uint32_t)
+    {
+        std::uint64_t value;
+        if (::read(ready_fd, &value, sizeof(value)) == sizeof(value))
+        {
+            on_worker = std::this_thread::get_id() != caller;
+            received.fetch_add(value);
+        }
+    });
+    std::uint64_t value = 3;
+    CHECK(::write(fd, &value, sizeof(value)) == sizeof(value));
+    CHECK(wait_until([&]() { return received.load() == 3; }));
+    CHECK(on_worker.load());
+    value = 4; // 回调结束后重新注册,后续事件同样会分发
+    CHECK(::write(fd, &value, sizeof(value)) == sizeof(value));
+    CHECK(wait_until([&]() { return received.load() == 7; }));
+    pool.get_reactor().remove(fd);
+    ::close(fd);
+}
+
+static void test_blocking_section() // 单线程的线程池中,阻塞区内等待不会让排队的任务饿死
+{
+    my_thread_poll::ThreadPool pool(1);
+    std::atomic<bool> signalled{false};
+    auto waiter = pool.submit([&]()
+    {
+        my_thread_poll::ThreadPool::blocking_section section(pool);
+        return wait_until([&]() { return signalled.load(); }); // 补偿线程执行排队的任务
+    });
+    auto signaller = pool.submit([&]() { signalled = true; });
+    CHECK(waiter.get());
+    signaller.get();
+    std::atomic<bool> released{false};
+    auto blocking = pool.submit_blocking([&]() { return wait_until([&]() { return released.load(); }); });
+    CHECK(pool.submit([&]() { released = true; return 5; }).get() == 5);
+    CHECK(blocking.get());
+}
+
+static void test_nested_pool_future_wait() // 单个工作线程上等待子任务时执行排队的任务,不会死锁
+{
+    my_thread_poll::ThreadPool pool(1);
+    auto outer = pool.async([&]()
+    {
+        auto inner = pool.async([](int x) { return x * 3; }, 7);
+        inner.wait();
+        auto deeper = pool.async([&]() { return pool.async([]() { return 1; }).get() + 1; });
+        return inner.get() + deeper.get();
+    });
+    CHECK(outer.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(outer.get() == 23);
+}
+
+static void test_async_values_and_exceptions() // async返回任务的结果,并重新抛出任务中的异常
+{
+    my_thread_poll::ThreadPool pool(2);
+    CHECK(pool.async([](int a, int b) { return a + b; }, 2, 3).get() == 5);
+    CHECK(pool.async([]() { return std::string("pool"); }).get() == "pool");
+    auto done = pool.async([]() {});
+    done.wait();
+    CHECK(done.is_ready());
+    done.get();
+    CHECK(!done.valid()); // 与std::future相同,get之后不再持有共享状态
+    bool threw = false;
+    try { pool.async([]() -> int { throw std::logic_error("async"); }).get(); }
+    catch (const std::logic_error &e) { threw = std::string(e.what()) == "async"; }
+    CHECK(threw);
+    std::vector<my_thread_poll::pool_future<int>> futures;
+    for (int i = 0; i < 100; ++i)
+        futures.push_back(pool.async([i]() { return i; }));
+    int sum = 0;
+    for (auto &future : futures)
+        sum += future.get();
+    CHECK(sum == 4950);
+}
+
+// 同一个尚未就绪的future先交给when_any,再从其结果中取出交给when_all,when_all必须等到该输入真正就绪
+static void test_combine_pending_future_twice()
+{
+    my_thread_poll::ThreadPool pool(2);
+    std::atomic<bool> release{false};
+    auto fast = pool.async([]() { return 1; });
+    auto slow = pool.async([&]()
+                           { while (!release.load()) std::this_thread::yield(); return 2; });
+    auto any = my_thread_poll::when_any(std::move(fast), std::move(slow)).get();
+    CHECK(any.index == 0);
+    auto &pending = std::get<1>(any.futures);
+    CHECK(!pending.is_ready());
+
+    auto all = my_thread_poll::when_all(std::move(pending));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!all.is_ready());
+    release = true;
+    auto gathered = all.get();
+    CHECK(std::get<0>(gathered).get() == 2);
+    CHECK(std::get<0>(any.futures).get() == 1);
+}
+
+// 每个任务结束后内存池整体释放:后一个任务从初始缓冲区的起点重新分配,溢出到上游的内存全部归还
+static void test_arena_reset_between_tasks()
+{
+    struct counting_resource : std::pmr::memory_resource
+    {
+        std::atomic<int> live{0};
+        void *do_allocate(std::size_t bytes, std::size_t align) override
+        {
+            ++live;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void *p, std::size_t bytes, std::size_t align) override
+        {
+            --live;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    } upstream;
+
+    my_thread_poll::ThreadPool pool(1);
+    pool.set_arena(1024, &upstream);
+    auto first_block = [&]()
+    {
+        return pool.submit([]() { return my_thread_poll::ThreadPool::current_arena()->allocate(256); }).get();
+    };
+    void *first = first_block();
+    void *second = first_block();
+    CHECK(first == second);
+
+    std::atomic<int> live_in_task{0};
+    pool.submit([&]()
+                {
+                    auto *arena = my_thread_poll::ThreadPool::current_arena();
+                    for (int i = 0; i < 8; ++i)
+                        (void)arena->allocate(4096);
+                    live_in_task = upstream.live.load(); })
+        .get();
+    CHECK(live_in_task.load() > 0);
+    CHECK(wait_until([&]() { return upstream.live.load() == 0; }));
+    CHECK(first_block() == first);
+    pool.shutdown();
+}
+
+// 并行算法在随机输入(包括空区间与单个元素)上的结果与对应的标准算法一致
+static void test_parallel_algorithms_match_std()
+{
+    my_thread_poll::ThreadPool pool(4);
+    std::mt19937 rng(20261019);
+    for (std::size_t n : {std::size_t(0), std::size_t(1), std::size_t(7), std::size_t(200003)})
+    {
+        std::vector<int> input(n);
+        for (auto &x : input)
+            x = static_cast<int>(rng() % 1000) - 500;
+
+        std::vector<long long> expected_map(n), mapped(n);
+        auto square = [](int x) { return static_cast<long long>(x) * x; };
+        std::transform(input.begin(), input.end(), expected_map.begin(), square);
+        CHECK(my_thread_poll::parallel_transform(pool, input.begin(), input.end(), mapped.begin(), square) == mapped.end());
+        CHECK(mapped == expected_map);
+
+        auto negative = [](int x) { return x < 0; };
+        CHECK(my_thread_poll::parallel_count_if(pool, input.begin(), input.end(), negative) ==
+              std::count_if(input.begin(), input.end(), negative));
+
+        std::vector<long long> expected_scan(n), scanned(n);
+        std::inclusive_scan(input.begin(), input.end(), expected_scan.begin(), std::plus<long long>());
+        CHECK(my_thread_poll::parallel_inclusive_scan(pool, input.begin(), input.end(), scanned.begin(), std::plus<long long>()) == scanned.end());
+        CHECK(scanned == expected_scan);
+
+        std::vector<int> expected_sort = input, sorted = input;
+        std::sort(expected_sort.begin(), expected_sort.end(), std::greater<>());
+        my_thread_poll::parallel_sort(pool, sorted.begin(), sorted.end(), std::greater<>());
+        CHECK(sorted == expected_sort);
+    }
+}
+
+// basic_thread_pool:post带参数、异常交给异常策略、与shutdown并发的提交要么被拒绝要么一定被执行
+static void test_basic_pool_post_exceptions_and_shutdown()
+{
+    using namespace my_thread_poll;
+    {
+        basic_thread_pool<unbounded_queue_policy, pooled_task_policy, condvar_idle_policy, no_stats_policy, handler_exception_policy> pool(2);
+        std::atomic<int> handled{0}, sum{0};
+        pool.set_exception_handler([&](std::exception_ptr e)
+        {
+            try { std::rethrow_exception(e); }
+            catch (const std::logic_error &) { handled.fetch_add(1); }
+        });
+        pool.post([&](int a, int b) { sum.fetch_add(a + b); }, 2, 3);
+        pool.post([](int) { throw std::logic_error("post"); }, 1);
+        CHECK(wait_until([&]() { return handled.load() == 1 && sum.load() == 5; }));
+    }
+    for (int round = 0; round < 50; ++round)
+    {
+        std::atomic<int> accepted{0}, executed{0};
+        std::vector<std::thread> producers;
+        {
+            default_thread_pool pool(2);
+            for (int i = 0; i < 4; ++i)
+            {
+                producers.emplace_back([&]()
+                {
+                    for (int j = 0; j < 200; ++j)
+                    {
+                        try { pool.post([&executed]() { executed.fetch_add(1); }); accepted.fetch_add(1); }
+                        catch (const std::runtime_error &) { return; }
+                    }
+                });
+            }
+            pool.shutdown();
+            for (auto &producer : producers)
+                producer.join();
+        }
+        CHECK(executed.load() == accepted.load());
+    }
+}
+
+// 延迟启动的线程池上add_thread只增加尚未启动的线程数量,任务到来或预热时才启动
+static void test_lazy_add_thread()
+{
+    my_thread_poll::ThreadPool pool(1, 0, 1, true);
+    pool.add_thread(2);
+    CHECK(pool.get_thread_count() == 0);
+    CHECK(pool.get_configured_thread_count() == 3);
+    CHECK(pool.submit([]() { return 3; }).get() == 3);
+    CHECK(pool.get_thread_count() >= 1);
+    CHECK(pool.get_configured_thread_count() == 3);
+    pool.prewarm();
+    CHECK(pool.get_thread_count() == 3);
+    CHECK(pool.get_configured_thread_count() == 3);
+
+    my_thread_poll::ThreadPool eager(1);
+    eager.add_thread(2);
+    CHECK(eager.get_thread_count() == 3);
+}
+
+// 分片中的积压取空后即退出过载,即使此时类别队列中仍有任务
+static void test_overload_clears_with_class_backlog()
+{
+    my_thread_poll::ThreadPool pool(1);
+    std::size_t other = pool.add_task_class(1);
+    std::atomic<bool> started{false}, release{false};
+    auto blocker = pool.submit([&]() { started = true; while (!release.load()) std::this_thread::yield(); });
+    CHECK(wait_until([&]() { return started.load(); }));
+    pool.set_admission_control(std::chrono::milliseconds(1), std::chrono::milliseconds(1));
+    auto slow = []() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); };
+    for (int i = 0; i < 10; ++i)
+        pool.post(slow);
+    for (int i = 0; i < 40; ++i)
+        pool.post_class(other, slow);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    release = true;
+    blocker.get();
+    CHECK(wait_until([&]() { return pool.is_overloaded(); }));
+    CHECK(wait_until([&]() { return pool.get_task_class_stats(0).queued == 0; }));
+    CHECK(pool.get_task_class_stats(other).queued > 0);
+    bool accepted = true;
+    try { pool.submit([]() {}).get(); } catch (const std::runtime_error &) { accepted = false; }
+    CHECK(accepted);
+    CHECK(!pool.is_overloaded());
+    pool.wait();
+}
+
+int main()
+{
+    test_submit_post();
+    test_remove_thread_submit_to();
+    test_task_class_limits();
+    test_bounded_queue_capacity();
+    test_lazy_start();
+    test_terminate_for();
+    test_admission_shed();
+    test_config_reload_lazy();
+    test_strand_ordering();
+    test_pipeline_order_and_backpressure();
+    test_shutdown_for_remaining();
+    test_task_class_weights();
+    test_deadline_order_and_expiry();
+    test_reactor_eventfd();
+    test_blocking_section();
+    test_nested_pool_future_wait();
+    test_async_values_and_exceptions();
+    test_combine_pending_future_twice();
+    test_arena_reset_between_tasks();
+    test_parallel_algorithms_match_std();
+    test_basic_pool_post_exceptions_and_shutdown();
+    test_lazy_add_thread();
+    test_overload_clears_with_class_backlog();
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
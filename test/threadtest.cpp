@@ -1,6 +1,13 @@
 #include <iostream>
 #include <cassert>
 #include "threadPool.h"
+#include "strand.h"
+#include "pipeline.h"
+#include "reactor.h"
+#include "whenAll.h"
+#include "basicThreadPool.h"
+#include "configWatcher.h"
+#include <unistd.h>
 #include "ini.h"
 
 using namespace utils;
@@ -37,5 +44,113 @@ int main() {
     std::cout<<pool.get_thread_count()<<std::endl;
     pool.remove_thread(2);
     std::cout<<pool.get_thread_count()<<std::endl;
+    // 提交不需要返回值的任务,异常交给异常处理函数
+    pool.set_exception_handler([](std::exception_ptr e){
+        try { std::rethrow_exception(e); }
+        catch(const std::exception &ex) { std::cout<<"post exception:"<<ex.what()<<std::endl; }
+    });
+    pool.post(add,3,4);
+    pool.execute(throw_exception);
+    pool.wait();
+    // 相同键的任务交给同一个工作线程执行,等待超过1ms后才允许被其他线程窃取
+    pool.set_steal_delay(std::chrono::milliseconds(1));
+    std::cout<<pool.submit_affine(42,add,7,8).get()<<std::endl;
+    std::cout<<pool.submit_to(0,add,9,10).get()<<std::endl;
+    // 按权重在任务类别之间分配执行机会,每个类别有独立的队列上限
+    std::size_t tenant=pool.add_task_class(2,100);
+    std::cout<<pool.submit_class(tenant,add,11,12).get()<<std::endl;
+    auto stats=pool.get_task_class_stats(tenant);
+    std::cout<<"tenant submitted:"<<stats.submitted<<" executed:"<<stats.executed<<std::endl;
+    // 截止时间早的任务先执行,开启过期丢弃后已过截止时间的任务不再执行
+    pool.set_drop_expired(true);
+    auto deadline=std::chrono::steady_clock::now()+std::chrono::milliseconds(100);
+    std::cout<<pool.submit_deadline(deadline,add,13,14).get()<<std::endl;
+    // 同一个键的任务按提交顺序串行执行
+    my_thread_poll::StrandGroup<int> strands(pool,4);
+    for(int i=0;i<3;++i)
+    {
+        strands.post_ordered(1,[i](){ std::cout<<"strand task:"<<i<<std::endl; });
+    }
+    std::cout<<strands.submit_ordered(1,add,5,6).get()<<std::endl;
+    // 流水线:读取->并行计算->按顺序输出,同时最多处理4个数据项
+    struct item_t { int value; int result; };
+    int next_value=0;
+    my_thread_poll::Pipeline<item_t> pipeline(pool);
+    pipeline.source([&](item_t &item){ if(next_value==5) return false; item.value=next_value++; return true; })
+        .stage(my_thread_poll::stage_mode::PARALLEL,[](item_t &item){ item.result=add(item.value,item.value); })
+        .stage(my_thread_poll::stage_mode::SERIAL_IN_ORDER,[](item_t &item){ std::cout<<"pipeline:"<<item.value<<"->"<<item.result<<std::endl; });
+    pipeline.run(4);
+    // 阻塞任务在阻塞区中执行,线程池临时创建补偿线程,其他任务不会因此排队
+    auto blocking_future=pool.submit_blocking([](){ std::this_thread::sleep_for(std::chrono::milliseconds(10)); return 1; });
+    std::cout<<pool.submit(add,1,2).get()<<" "<<blocking_future.get()<<std::endl;
+    // 任务中提交子任务并等待结果,工作线程等待时会执行子任务,不会因工作线程耗尽而死锁
+    auto outer=pool.async([&pool](){ return pool.async(add,20,22).get(); });
+    std::cout<<"nested:"<<outer.get()<<std::endl;
+    // 分发多个子任务,全部完成后一次性取回结果
+    auto gathered=my_thread_poll::when_all(pool.async(add,1,1),pool.async(add,2,2)).get();
+    std::cout<<"when_all:"<<std::get<0>(gathered).get()<<" "<<std::get<1>(gathered).get()<<std::endl;
+    // 任务中的临时对象从工作线程的内存池中分配,任务结束后整体释放
+    auto arena_size=pool.async([](){
+        std::pmr::vector<int> temp(my_thread_poll::ThreadPool::current_arena());
+        for(int i=0;i<100;++i) temp.push_back(i);
+        return temp.size();
+    }).get();
+    std::cout<<"arena:"<<arena_size<<std::endl;
+    // 编译期组合的线程池:有上限的队列、统计任务数量
+    {
+        my_thread_poll::basic_thread_pool<my_thread_poll::bounded_queue_policy<16>,my_thread_poll::pooled_task_policy,
+            my_thread_poll::condvar_idle_policy,my_thread_poll::atomic_stats_policy> basic_pool(2);
+        std::cout<<"basic_thread_pool:"<<basic_pool.submit(add,3,4).get()<<std::endl;
+        basic_pool.shutdown();
+        std::cout<<"executed:"<<basic_pool.stats().executed<<std::endl;
+    }
+    // 延迟启动:构造时不创建线程,prewarm并行启动并预热全部线程
+    {
+        my_thread_poll::ThreadPool lazy_pool(4,0,1,true);
+        std::cout<<"lazy threads:"<<lazy_pool.get_thread_count();
+        lazy_pool.prewarm();
+        std::cout<<" after prewarm:"<<lazy_pool.get_thread_count()<<std::endl;
+    }
+    // 限时终止:所有线程同时退出,超时仍在执行任务的线程在析构时回收
+    {
+        my_thread_poll::ThreadPool teardown_pool(8);
+        bool all_exited=teardown_pool.terminate_for(std::chrono::milliseconds(100));
+        std::cout<<"terminate_for:"<<all_exited<<" threads left:"<<teardown_pool.get_thread_count()<<std::endl;
+    }
+    // 准入控制:排队时间持续超过5ms时拒绝新任务
+    {
+        my_thread_poll::ThreadPool admission_pool(2);
+        admission_pool.set_admission_control(std::chrono::milliseconds(5));
+        std::cout<<"admission:"<<admission_pool.submit(add,5,6).get()<<" overloaded:"<<admission_pool.is_overloaded()<<std::endl;
+    }
+    // 配置热加载:修改config.ini的[thread_pool]分区后自动调整线程数量与最大任务数量
+    {
+        my_thread_poll::ThreadPool watched_pool(2);
+        my_thread_poll::ConfigWatcher watcher(watched_pool,"/home/fengxu/thread/mythreadPoll/config/config.ini");
+        watcher.reload();
+        std::cout<<"config reloads:"<<watcher.get_reload_count()<<" threads:"<<watched_pool.get_thread_count()<<std::endl;
+    }
+    // 调度开销统计,需要以-DTHREAD_POOL_PROFILE=ON构建
+    my_thread_poll::profile::report(std::cout);
+    // 反应器:管道可读时在工作线程中读取数据,而不是阻塞在read上
+    int fds[2];
+    if(pipe(fds)==0)
+    {
+        std::promise<char> received;
+        auto received_future=received.get_future();
+        pool.get_reactor().add(fds[0],EPOLLIN,[&](int fd,std::uint32_t){
+            char c;
+            if(read(fd,&c,1)==1) received.set_value(c);
+        });
+        char c='x';
+        if(write(fds[1],&c,1)==1)
+            std::cout<<"reactor read:"<<received_future.get()<<std::endl;
+        pool.get_reactor().remove(fds[0]);
+        close(fds[0]);
+        close(fds[1]);
+    }
+    // 最多等待100ms后关闭线程池,取回尚未执行的任务
+    auto remaining=pool.shutdown_for(std::chrono::milliseconds(100));
+    std::cout<<"remaining tasks:"<<remaining.size()<<std::endl;
 
 }
\ No newline at end of file